@@ -2,31 +2,123 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include "registry.h"
+
+#ifdef _WIN32
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/wait.h>
+#endif
 
 #define MAX_CHAR_MAP 256
 #define MAX_FILENAME 100
 #define MAX_LINE_LENGTH 1024
+#define MAX_COMMAND 256
+#define SNIFF_LENGTH 4096  // decoded characters looked at to tell C from Python
+#define C_COMPILER "gcc"
+#define PYTHON_PROGRAM "python"
 
 // Function prototypes
 void load_char_map(void);
+int read_char_map(int file_number);
 void encode_file(void);
 void decode_file(void);
+void run_file(void);
+void describe_file(int file_number);
+int decode_all_files(void);
+int run_encoded_file(int file_number, const char *language);
+int next_decoded_char(const char **cursor);
 int find_char_index(char c);
+int append_text(char **buffer, size_t *length, size_t *capacity, const char *text);
 
 // Character mapping array that will be loaded from file
 char char_map[MAX_CHAR_MAP];
 int char_map_size = 0;
 int is_map_loaded = 0;
 
-int main() {
+// Roles and paths of the numbered files, from 0.txt
+Registry *registry = NULL;
+
+int main(int argc, char *argv[]) {
     int choice = 0;
     
+    registry = registry_open(".");
+    
+    // Command line use: --run N [--map M] [--lang c|py] runs N.txt without
+    // writing its decoded source anywhere, using M.txt (default: the
+    // mapping file named in 0.txt, else 1.txt) as the character map.
+    // --decode-all decodes every encoded file 0.txt pairs with a decoded
+    // one, skipping those whose decoded file is already newer.
+    // --shard moves to the ab/cd/N.txt layout, --pack bundles small files
+    // into packs/ and --dedup stores encoded files as chunks; the other
+    // options find files either way.
+    int run_number = -1;
+    int map_number = -1;
+    const char *language = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--run") == 0 && i + 1 < argc) {
+            run_number = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            map_number = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lang") == 0 && i + 1 < argc) {
+            language = argv[++i];
+            if (strcmp(language, "c") != 0 && strcmp(language, "py") != 0) {
+                printf("Error: --lang must be c or py, not %s\n", language);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--decode-all") == 0) {
+            int map = registry_find_role(registry, "mapping file");
+            if (!read_char_map(map >= 0 ? map : 1)) {
+                return 1;
+            }
+            return decode_all_files() < 0 ? 1 : 0;
+        } else if (strcmp(argv[i], "--shard") == 0) {
+            int moved = registry_shard(registry);
+            if (moved < 0) {
+                printf("Error: Could not shard the directory\n");
+                return 1;
+            }
+            printf("Moved %d files into shard directories.\n", moved);
+            return 0;
+        } else if (strcmp(argv[i], "--pack") == 0) {
+            int packed = registry_pack(registry);
+            if (packed < 0) {
+                printf("Error: Could not pack the directory\n");
+                return 1;
+            }
+            printf("Packed %d files into " REGISTRY_PACK_DIRECTORY "/\n", packed);
+            return 0;
+        } else if (strcmp(argv[i], "--dedup") == 0) {
+            int converted = registry_deduplicate(registry);
+            if (converted < 0) {
+                printf("Error: Could not deduplicate the directory\n");
+                return 1;
+            }
+            printf("Stored %d encoded files as chunks in " REGISTRY_CHUNK_DIRECTORY "/\n", converted);
+            return 0;
+        } else {
+            printf("Usage: %s [--run N [--map M] [--lang c|py] | --decode-all | --shard | --pack | --dedup]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (run_number >= 0) {
+        if (map_number < 0) {
+            map_number = registry_find_role(registry, "mapping file");
+        }
+        if (!read_char_map(map_number >= 0 ? map_number : 1)) {
+            return 1;
+        }
+        return run_encoded_file(run_number, language);
+    }
+    
     while (1) {
         printf("\nC Source Code Encoder/Decoder\n");
         printf("1. Load character mapping from file\n");
         printf("2. Encode C file to numeric format\n");
         printf("3. Decode numeric file to C source code\n");
         printf("4. Exit\n");
+        printf("5. Run encoded file without decoding it to disk\n");
         printf("Enter your choice: ");
         
         if (scanf("%d", &choice) != 1) {
@@ -57,6 +149,13 @@ int main() {
             case 4:
                 printf("Exiting program. Goodbye!\n");
                 return 0;
+            case 5:
+                if (!is_map_loaded) {
+                    printf("Please load a character map first (option 1).\n");
+                } else {
+                    run_file();
+                }
+                break;
             default:
                 printf("Invalid choice. Please try again.\n");
                 break;
@@ -68,22 +167,42 @@ int main() {
 
 // Load the character mapping from a user-specified file
 void load_char_map(void) {
-    char filename[MAX_FILENAME];
-    FILE *file;
-    char line[MAX_LINE_LENGTH];
-    
     // Clear input buffer
     while (getchar() != '\n');
     
     printf("Enter the file number containing the character mapping (will load from [number].txt): ");
     int file_number;
     scanf("%d", &file_number);
-    snprintf(filename, MAX_FILENAME, "%d.txt", file_number);
     
-    file = fopen(filename, "r");
-    if (!file) {
-        printf("Error: Could not open mapping file %s\n", filename);
-        return;
+    if (read_char_map(file_number)) {
+        printf("Character mapping loaded successfully with %d characters.\n", char_map_size);
+        
+        // Print out the mapping for verification
+        printf("Loaded character map:\n");
+        for (int i = 0; i < char_map_size; i++) {
+            if (isprint(char_map[i])) {
+                printf("%d: '%c'\n", i + 1, char_map[i]);
+            } else {
+                printf("%d: '\\x%02x'\n", i + 1, (unsigned char)char_map[i]);
+            }
+        }
+    }
+    
+    // Clear input buffer
+    while (getchar() != '\n');
+}
+
+// Read numbered mapping file N.txt into char_map. Returns 1 on success.
+int read_char_map(int file_number) {
+    char *data;
+    const char *cursor;
+    char line[MAX_LINE_LENGTH];
+    char filename[MAX_FILENAME];
+    
+    data = registry_read(registry, file_number, NULL);
+    if (!data) {
+        printf("Error: Could not open mapping file %s\n", registry_path(registry, file_number, filename, MAX_FILENAME));
+        return 0;
     }
     
     // Reset the character map
@@ -93,10 +212,11 @@ void load_char_map(void) {
     // Read each line from the file
     // Format expected: index<tab>character
     int line_num = 0;
-    while (fgets(line, MAX_LINE_LENGTH, file) && char_map_size < MAX_CHAR_MAP) {
+    cursor = data;
+    while (registry_gets(line, MAX_LINE_LENGTH, &cursor) && char_map_size < MAX_CHAR_MAP) {
         line_num++;
         // Remove newline character if present
-        line[strcspn(line, "\n")] = 0;
+        line[strcspn(line, "\r\n")] = 0;
         
         // Parse the line: index<tab>character
         int index;
@@ -151,22 +271,9 @@ void load_char_map(void) {
         }
     }
     
-    fclose(file);
+    free(data);
     is_map_loaded = 1;
-    printf("Character mapping loaded successfully with %d characters.\n", char_map_size);
-    
-    // Print out the mapping for verification
-    printf("Loaded character map:\n");
-    for (int i = 0; i < char_map_size; i++) {
-        if (isprint(char_map[i])) {
-            printf("%d: '%c'\n", i + 1, char_map[i]);
-        } else {
-            printf("%d: '\\x%02x'\n", i + 1, (unsigned char)char_map[i]);
-        }
-    }
-    
-    // Clear input buffer
-    while (getchar() != '\n');
+    return 1;
 }
 
 // Find the index of a character in the char_map array
@@ -179,11 +286,34 @@ int find_char_index(char c) {
     return -1; // Character not found
 }
 
+// Append text to a growing malloc'd buffer. Returns 0 if memory ran out,
+// leaving the buffer as it was.
+int append_text(char **buffer, size_t *length, size_t *capacity, const char *text) {
+    size_t size = strlen(text);
+    if (*length + size + 1 > *capacity) {
+        size_t grown_capacity = *capacity ? *capacity * 2 : 65536;
+        while (*length + size + 1 > grown_capacity) {
+            grown_capacity *= 2;
+        }
+        char *grown = realloc(*buffer, grown_capacity);
+        if (!grown) {
+            return 0;
+        }
+        *buffer = grown;
+        *capacity = grown_capacity;
+    }
+    memcpy(*buffer + *length, text, size + 1);
+    *length += size;
+    return 1;
+}
+
 // Encode a C source file to a numeric format
 void encode_file(void) {
     char input_filename[MAX_FILENAME];
     char output_filename[MAX_FILENAME];
-    FILE *input_file, *output_file;
+    FILE *input_file, *output_file = NULL;
+    char *encoded = NULL;
+    size_t encoded_length = 0, encoded_capacity = 0;
     int c;
     
     // Clear input buffer
@@ -196,7 +326,8 @@ void encode_file(void) {
     printf("Enter the output file number (will be saved as [number].txt): ");
     int file_number;
     scanf("%d", &file_number);
-    snprintf(output_filename, MAX_FILENAME, "%d.txt", file_number);
+    registry_create_path(registry, file_number, output_filename, MAX_FILENAME);
+    describe_file(file_number);
     
     input_file = fopen(input_filename, "r");
     if (!input_file) {
@@ -204,30 +335,71 @@ void encode_file(void) {
         return;
     }
     
-    output_file = fopen(output_filename, "w");
-    if (!output_file) {
-        printf("Error: Could not open output file %s\n", output_filename);
-        fclose(input_file);
-        return;
+    // With the chunk store on, the output is collected in memory first and
+    // only its new chunks are written
+    if (!registry->deduplicated) {
+        output_file = fopen(output_filename, "w");
+        if (!output_file) {
+            printf("Error: Could not open output file %s\n", output_filename);
+            fclose(input_file);
+            return;
+        }
     }
     
     printf("Encoding file %s to %s...\n", input_filename, output_filename);
     
     // Read each character from the input file
     while ((c = fgetc(input_file)) != EOF) {
+        // CRLF encodes as a bare newline, as text mode reads it on Windows
+        // and Python everywhere, so a source encodes the same on every system
+        if (c == '\r') {
+            int next = fgetc(input_file);
+            if (next == '\n') {
+                c = next;
+            } else if (next != EOF) {
+                ungetc(next, input_file);
+            }
+        }
         int index = find_char_index((char)c);
+        char code[16];
         if (index != -1) {
-            fprintf(output_file, "%d ", index);
+            snprintf(code, sizeof(code), "%d ", index);
         } else {
             // For characters not in our mapping, we could use a special code or skip
             // Here we'll use 0 to represent unmapped characters
-            fprintf(output_file, "0 ");
+            strcpy(code, "0 ");
+        }
+        if (output_file) {
+            fputs(code, output_file);
+        } else if (!append_text(&encoded, &encoded_length, &encoded_capacity, code)) {
+            break;
         }
     }
     
     fclose(input_file);
-    fclose(output_file);
-    printf("Encoding complete.\n");
+    int ok;
+    if (output_file) {
+        ok = fclose(output_file) == 0;
+        if (!ok) {
+            printf("Error: Could not write %s\n", output_filename);
+        }
+    } else if (c != EOF) {
+        printf("Error: Out of memory encoding %s\n", input_filename);
+        ok = 0;
+    } else {
+        ok = registry_store(registry, file_number, encoded ? encoded : "", encoded_length);
+        if (ok) {
+            printf("Stored %d chunks, %d new (%lld bytes written).\n",
+                   registry->stored_chunks, registry->new_chunks, registry->new_bytes);
+        }
+    }
+    free(encoded);
+    registry_invalidate(registry, file_number);
+    if (ok) {
+        printf("Encoding complete.\n");
+    } else {
+        printf("Encoding failed.\n");
+    }
     
     // Clear input buffer
     while (getchar() != '\n');
@@ -237,8 +409,10 @@ void encode_file(void) {
 void decode_file(void) {
     char input_filename[MAX_FILENAME];
     char output_filename[MAX_FILENAME];
-    FILE *input_file, *output_file;
-    int index;
+    char *input;
+    const char *cursor;
+    FILE *output_file;
+    int c;
     
     // Clear input buffer
     while (getchar() != '\n');
@@ -246,17 +420,18 @@ void decode_file(void) {
     printf("Enter the input file number to decode (e.g., for 5.txt, enter 5): ");
     int file_number;
     scanf("%d", &file_number);
-    snprintf(input_filename, MAX_FILENAME, "%d.txt", file_number);
+    registry_path(registry, file_number, input_filename, MAX_FILENAME);
+    describe_file(file_number);
+    input = registry_read(registry, file_number, NULL);
     
     // Clear input buffer
     while (getchar() != '\n');
     
     printf("Enter the output file number for the decoded C source (will be saved as [number].txt): ");
     scanf("%d", &file_number);
-    snprintf(output_filename, MAX_FILENAME, "%d.txt", file_number);
+    registry_create_path(registry, file_number, output_filename, MAX_FILENAME);
     
-    input_file = fopen(input_filename, "r");
-    if (!input_file) {
+    if (!input) {
         printf("Error: Could not open input file %s\n", input_filename);
         return;
     }
@@ -264,26 +439,195 @@ void decode_file(void) {
     output_file = fopen(output_filename, "w");
     if (!output_file) {
         printf("Error: Could not open output file %s\n", output_filename);
-        fclose(input_file);
+        free(input);
         return;
     }
     
     printf("Decoding file %s to %s...\n", input_filename, output_filename);
     
-    // Read each number from the input file
-    while (fscanf(input_file, "%d", &index) == 1) {
-        if (index > 0 && index <= char_map_size) {
-            fputc(char_map[index - 1], output_file); // -1 because our list is 1-indexed
-        } else if (index == 0) {
-            // Handle unmapped characters (we used 0 as a special code)
-            fputc('?', output_file); // Replace with some placeholder
-        }
+    // Read each number from the input and write its character
+    cursor = input;
+    while ((c = next_decoded_char(&cursor)) != EOF) {
+        fputc(c, output_file);
     }
     
-    fclose(input_file);
+    free(input);
     fclose(output_file);
+    registry_invalidate(registry, file_number);
     printf("Decoding complete.\n");
     
     // Clear input buffer
     while (getchar() != '\n');
+}
+
+// Ask for an encoded file and run it (see run_encoded_file)
+void run_file(void) {
+    // Clear input buffer
+    while (getchar() != '\n');
+    
+    printf("Enter the encoded file number to run (e.g., for 5.txt, enter 5): ");
+    int file_number;
+    scanf("%d", &file_number);
+    describe_file(file_number);
+    run_encoded_file(file_number, NULL);
+    
+    // Clear input buffer
+    while (getchar() != '\n');
+}
+
+// Read the next number at *cursor in an encoded file's text, move past it
+// and map it back to its character. Returns EOF at the end; unmapped codes
+// (0, as encode_file writes them) decode to '?'.
+int next_decoded_char(const char **cursor) {
+    char *end;
+    long index;
+    while ((index = strtol(*cursor, &end, 10)), end != *cursor) {
+        *cursor = end;
+        if (index > 0 && index <= char_map_size) {
+            return (unsigned char)char_map[index - 1];
+        } else if (index == 0) {
+            return '?';
+        }
+    }
+    return EOF;
+}
+
+// Decode N.txt straight into "gcc -x c -" or "python -" through a pipe,
+// so the decoded source only ever exists in memory. Only the first
+// SNIFF_LENGTH characters are held back, to tell C (an #include) from
+// Python when language is NULL; the rest is passed on as it is decoded.
+// C programs are built as N.out (N.exe on Windows), run, and removed.
+// Returns the program's exit status, or 1 if it could not be started,
+// failed to compile or was killed by a signal.
+int run_encoded_file(int file_number, const char *language) {
+    char input_filename[MAX_FILENAME];
+    char program[MAX_FILENAME];
+    char command[MAX_COMMAND];
+    char *input;
+    const char *cursor;
+    FILE *pipe;
+    char sniff[SNIFF_LENGTH + 1];
+    int sniffed = 0;
+    int c;
+    
+    registry_path(registry, file_number, input_filename, MAX_FILENAME);
+    input = registry_read(registry, file_number, NULL);
+    if (!input) {
+        printf("Error: Could not open input file %s\n", input_filename);
+        return 1;
+    }
+    
+    cursor = input;
+    while (sniffed < SNIFF_LENGTH && (c = next_decoded_char(&cursor)) != EOF) {
+        sniff[sniffed++] = (char)c;
+    }
+    sniff[sniffed] = '\0';
+    int is_c = language ? strcmp(language, "c") == 0 : strstr(sniff, "#include") != NULL;
+    
+#ifdef _WIN32
+    snprintf(program, MAX_FILENAME, "%d.exe", file_number);
+#else
+    snprintf(program, MAX_FILENAME, "./%d.out", file_number);
+#endif
+    if (is_c) {
+        snprintf(command, MAX_COMMAND, C_COMPILER " -x c - -o %s", program);
+    } else {
+        snprintf(command, MAX_COMMAND, PYTHON_PROGRAM " -");
+    }
+    pipe = popen(command, "w");
+    if (!pipe) {
+        printf("Error: Could not start %s\n", command);
+        free(input);
+        return 1;
+    }
+    
+    fwrite(sniff, 1, sniffed, pipe);
+    while ((c = next_decoded_char(&cursor)) != EOF) {
+        fputc(c, pipe);
+    }
+    free(input);
+    int status = pclose(pipe);
+    
+    if (is_c) {
+        if (status != 0) {
+            printf("Error: %s failed to compile\n", input_filename);
+            return 1;
+        }
+        status = system(program);
+        remove(program);
+    }
+#ifndef _WIN32
+    // pclose() and system() hand back a wait status; a signal counts as failure
+    status = status != -1 && WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+#endif
+    return status;
+}
+
+// Print what 0.txt says a numbered file is, and its encoded or decoded
+// counterpart
+void describe_file(int file_number) {
+    const RegistryEntry *entry = registry_entry(registry, file_number);
+    if (!entry) {
+        return;
+    }
+    char filename[MAX_FILENAME];
+    printf("%s: %s\n", registry_path(registry, file_number, filename, MAX_FILENAME), entry->role);
+    if (entry->pair >= 0) {
+        printf("Its %s counterpart is %s\n", entry->encoded ? "decoded" : "encoded",
+               registry_path(registry, entry->pair, filename, MAX_FILENAME));
+    }
+}
+
+// Decode every encoded file 0.txt pairs with a decoded one. The
+// directory is read once up front, so deciding which pairs are stale
+// costs no per-file stat. Returns how many files were decoded, -1 if
+// the directory could not be read or a file failed.
+int decode_all_files(void) {
+    if (registry_scan(registry) < 0) {
+        printf("Error: Could not read directory %s\n", registry->directory);
+        return -1;
+    }
+    int decoded = 0, skipped = 0, failed = 0;
+    for (int id = 0; id < registry->entry_count; id++) {
+        const RegistryEntry *entry = registry_entry(registry, id);
+        if (!entry || entry->encoded != 1 || entry->pair < 0) {
+            continue;
+        }
+        // copied out: the next registry_stat may grow the table
+        const RegistryFile *input = registry_stat(registry, id);
+        if (!input || !input->exists) {
+            continue;
+        }
+        time_t input_mtime = input->mtime;
+        const RegistryFile *output = registry_stat(registry, entry->pair);
+        if (output && output->exists && output->mtime >= input_mtime) {
+            skipped++;
+            continue;
+        }
+        
+        char input_filename[MAX_FILENAME];
+        char output_filename[MAX_FILENAME];
+        registry_path(registry, id, input_filename, MAX_FILENAME);
+        registry_create_path(registry, entry->pair, output_filename, MAX_FILENAME);
+        char *encoded = registry_read(registry, id, NULL);
+        FILE *output_file = encoded ? fopen(output_filename, "w") : NULL;
+        if (!output_file) {
+            printf("Error: Could not decode %s to %s\n", input_filename, output_filename);
+            free(encoded);
+            failed++;
+            continue;
+        }
+        const char *cursor = encoded;
+        int c;
+        while ((c = next_decoded_char(&cursor)) != EOF) {
+            fputc(c, output_file);
+        }
+        free(encoded);
+        fclose(output_file);
+        registry_invalidate(registry, entry->pair);
+        printf("Decoded %s to %s\n", input_filename, output_filename);
+        decoded++;
+    }
+    printf("Decoded %d files, %d already up to date, %d failed.\n", decoded, skipped, failed);
+    return failed ? -1 : decoded;
 }
\ No newline at end of file
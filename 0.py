@@ -1,7 +1,9 @@
 import tkinter as tk
 from tkinter import ttk, scrolledtext, filedialog, messagebox
+import io
 import os
 from tkinter.font import Font
+from registry import Registry
 
 class SourceCodeEncoderDecoder:
     def __init__(self, root):
@@ -44,6 +46,7 @@ class SourceCodeEncoderDecoder:
         self.char_map = [None] * 256
         self.char_map_size = 0
         self.is_map_loaded = False
+        self.registry = Registry(".")
         
         # Create the UI
         self.apply_style()
@@ -414,6 +417,9 @@ class SourceCodeEncoderDecoder:
         decode_btn = ttk.Button(input_frame, text="◀ DECODE", command=self.decode_file)
         decode_btn.pack(side=tk.LEFT, padx=15)
         
+        decode_all_btn = ttk.Button(input_frame, text="◀◀ DECODE ALL", command=self.decode_all_files)
+        decode_all_btn.pack(side=tk.LEFT, padx=5)
+        
         # Preview frame with futuristic styling
         preview_frame = ttk.LabelFrame(parent, text="REVERSE ENGINEERING MATRIX")
         preview_frame.pack(fill=tk.BOTH, expand=True, padx=10, pady=10)
@@ -572,14 +578,15 @@ class SourceCodeEncoderDecoder:
         
         # Process file input - could be a number or a path
         if file_input.isdigit():
-            filename = f"{file_input}.txt"
+            filename = self.registry.path(int(file_input))
         else:
             filename = file_input
             
         self.status_var.set("LOADING CHARACTER MAP...")
         
         try:
-            with open(filename, 'r') as file:
+            # Numbered files may be sharded or packed
+            with (self.registry.open(int(file_input)) if file_input.isdigit() else open(filename, 'r')) as file:
                 # Reset the character map
                 self.char_map = [None] * 256
                 self.char_map_size = 0
@@ -786,11 +793,13 @@ class SourceCodeEncoderDecoder:
         self.status_var.set("INITIALIZING ENCODING PROCESS...")
         self.root.update()
         
-        output_filename = f"{output_file_number}.txt"
+        output_filename = self.registry.create_path(int(output_file_number))
         
         try:
-            # Open files
-            with open(input_filename, 'r') as input_file, open(output_filename, 'w') as output_file:
+            # Open files; with the chunk store on, the output is collected
+            # first and only its new chunks are written
+            output = io.StringIO() if self.registry.deduplicated else open(output_filename, 'w')
+            with open(input_filename, 'r') as input_file, output as output_file:
                 content = input_file.read()
                 
                 # Update progress
@@ -816,6 +825,9 @@ class SourceCodeEncoderDecoder:
                         encoded_content += "0 "
                         output_file.write("0 ")
                 
+                if self.registry.deduplicated:
+                    self.registry.store(int(output_file_number), encoded_content)
+                
                 # Update progress
                 self.progress['value'] = 80
                 self.status_var.set("FINALIZING ENCODED OUTPUT...")
@@ -849,6 +861,11 @@ class SourceCodeEncoderDecoder:
             messagebox.showwarning("WARNING", "Please enter an input file number")
             return
         
+        # An empty output defaults to the decoded counterpart listed in 0.txt
+        if not output_file_number and self.registry.pair(Registry.parse_number(input_file_number)) >= 0:
+            output_file_number = str(self.registry.pair(int(input_file_number)))
+            self.decode_output_entry.insert(0, output_file_number)
+        
         if not output_file_number:
             messagebox.showwarning("WARNING", "Please enter an output file number")
             return
@@ -860,11 +877,11 @@ class SourceCodeEncoderDecoder:
         
         # Determine if input is a number or a file path
         if input_file_number.isdigit():
-            input_filename = f"{input_file_number}.txt"
+            input_filename = self.registry.path(int(input_file_number))
         else:
             input_filename = input_file_number
             
-        output_filename = f"{output_file_number}.txt"
+        output_filename = self.registry.create_path(int(output_file_number)) if output_file_number.isdigit() else f"{output_file_number}.txt"
         
         try:
             # Update progress
@@ -872,7 +889,9 @@ class SourceCodeEncoderDecoder:
             self.status_var.set("READING ENCODED DATA...")
             self.root.update()
             
-            with open(input_filename, 'r') as input_file, open(output_filename, 'w') as output_file:
+            # Numbered files may be sharded or packed
+            opened = self.registry.open(int(input_file_number)) if input_file_number.isdigit() else open(input_filename, 'r')
+            with opened as input_file, open(output_filename, 'w') as output_file:
                 content = input_file.read()
                 decoded_content = ""
                 
@@ -931,6 +950,59 @@ class SourceCodeEncoderDecoder:
             messagebox.showerror("ERROR", f"Failed to decode file: {str(e)}")
             self.status_var.set(f"ERROR: {str(e)}")
 
+    def decode_all_files(self):
+        # Decode every encoded file 0.txt pairs with a decoded one, skipping
+        # pairs whose decoded file is already newer. One directory scan
+        # answers all the freshness checks.
+        if not self.is_map_loaded:
+            messagebox.showwarning("WARNING", "Please load a character map first")
+            return
+        
+        if self.registry.scan() < 0:
+            messagebox.showerror("ERROR", f"Could not read directory {self.registry.directory}")
+            return
+        
+        pairs = [(id, entry.pair) for id, entry in sorted(self.registry.entries.items())
+                 if entry.encoded == 1 and entry.pair >= 0]
+        decoded, skipped, failed = 0, 0, []
+        for done, (input_id, output_id) in enumerate(pairs):
+            input_exists, _, input_mtime = self.registry.stat(input_id)
+            output_exists, _, output_mtime = self.registry.stat(output_id)
+            if not input_exists:
+                continue
+            if output_exists and output_mtime >= input_mtime:
+                skipped += 1
+                continue
+            
+            self.progress['value'] = 100 * done // len(pairs)
+            self.status_var.set(f"DECODING {self.registry.path(input_id)}...")
+            self.root.update()
+            try:
+                with self.registry.open(input_id) as input_file:
+                    content = input_file.read()
+                with open(self.registry.create_path(output_id), 'w') as output_file:
+                    for index_str in content.split():
+                        try:
+                            index = int(index_str)
+                        except ValueError:
+                            continue
+                        if index > 0 and index <= self.char_map_size and self.char_map[index - 1] is not None:
+                            output_file.write(self.char_map[index - 1])
+                        elif index == 0:
+                            output_file.write('?')
+                self.registry.invalidate(output_id)
+                decoded += 1
+            except Exception as e:
+                failed.append(f"{self.registry.path(input_id)}: {str(e)}")
+        
+        self.progress['value'] = 100
+        summary = f"Decoded {decoded} files, {skipped} already up to date, {len(failed)} failed."
+        self.status_var.set(summary.upper())
+        if failed:
+            messagebox.showerror("ERROR", summary + "\n" + "\n".join(failed))
+        else:
+            messagebox.showinfo("OPERATION SUCCESSFUL", summary)
+
 if __name__ == "__main__":
     root = tk.Tk()
     app = SourceCodeEncoderDecoder(root)
@@ -4,56 +4,726 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <math.h>
+#include <string.h>
+#include <pthread.h>
+
+#ifdef _WIN32
+#define popen _popen    // Windows-specific popen alias
+#define pclose _pclose
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#endif
 
 // Program by Dominic Alexander Cooper
 
-int main() {
+#define DEFAULT_OUTPUT "SOLUTION_RENAME.txt"
+#define BENCH_SCRATCH "1_bench.tmp"
+#define MAX_CELLS 64
+#define MAX_THREADS 64
+#define MAX_BENCH_VALUES 16
+#define BLOCK_ROWS 16384
+
+// Enumeration orders
+#define ORDER_LEXICOGRAPHIC 0
+#define ORDER_GRAY 1
+
+// Output formats
+#define FORMAT_LEX 0
+#define FORMAT_GRAY 1
+#define FORMAT_DELTA 2
+
+// Output sinks
+#define SINK_FILE 0
+#define SINK_NULL 1
+#define SINK_GZIP 2
+
+static const char *format_names[] = { "lex", "gray", "delta" };
+static const char *sink_names[] = { "file", "null", "gzip" };
+
+//char a[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 \t\n";
+static const char a[] =
+"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+"!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~"
+" \t\n\r\f\v"
+;
+
+// Enumeration state: standard base-(k+1) counter plus the reflected Gray digits.
+// Digit 0 is the least significant cell, i.e. the last character of a record.
+typedef struct {
+    int n;
+    int radix;
+    int order;
+    int b[MAX_CELLS];   // plain counter digits
+    int g[MAX_CELLS];   // Gray digits (only used in ORDER_GRAY)
+    int dir[MAX_CELLS]; // +1 / -1 direction of each Gray digit
+} Enumerator;
+
+// Where generated bytes go; bytes counts everything handed to the sink
+typedef struct {
+    int kind;
+    FILE *fp;
+    unsigned long long bytes;
+} Sink;
+
+// One generator run
+typedef struct {
+    int n;
+    int radix;
+    int format;
+    int sink;
+    int threads;
+} GenConfig;
+
+// Ordered hand-off of formatted blocks from worker threads to the writer
+typedef struct {
+    const GenConfig *cfg;
+    unsigned long long first_row;
+    unsigned long long last_row;
+    unsigned long long nblocks;
+    unsigned long long next_block;    // next block a worker will claim
+    unsigned long long written_block; // next block the writer will flush
+    int nslots;
+    char **slot_data;
+    size_t *slot_len;
+    unsigned long long *slot_block;   // block stored in the slot, or ~0 when free
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+} BlockQueue;
+
+// Function prototypes
+void usage(const char *prog);
+int init_enumerator(Enumerator *e, int n, int radix, int order);
+void seek_enumerator(Enumerator *e, unsigned long long row);
+int step_enumerator(Enumerator *e);
+void render_record(const Enumerator *e, char *out);
+size_t block_capacity(const GenConfig *cfg);
+size_t format_block(const GenConfig *cfg, unsigned long long start, unsigned long long end, char *out);
+void* block_worker(void *arg);
+int open_sink(Sink *sink, int kind, const char *path, int binary);
+void sink_write(Sink *sink, const char *data, size_t len);
+int close_sink(Sink *sink);
+int generate(Sink *sink, const GenConfig *cfg);
+int expand_delta(FILE *in, FILE *out);
+int records_fit(int n, int radix);
+int parse_list(const char *text, int *values, int max);
+int parse_names(const char *text, const char **names, int count, int *values, int max);
+int run_benchmark(FILE *report, const int *ns, int nn, const int *radices, int nr,
+                  const int *formats, int nf, const int *sinks, int nsk, const int *threads, int nt);
+
+void usage(const char *prog) {
+    printf("Usage: %s [-n cells] [-r radix] [-g] [-d] [-j threads] [-s file|null|gzip] [-o output]\n", prog);
+    printf("       %s -x delta_file [-o output]\n", prog);
+    printf("       %s -B [-n list] [-r list] [-f list] [-s list] [-j list] [-o report]\n", prog);
+    printf("  -n cells   number of FILE cells (prompted for when omitted)\n");
+    printf("  -r radix   alphabet size k+1, using the first symbols of the alphabet\n");
+    printf("  -g         enumerate in reflected (k+1)-ary Gray-code order\n");
+    printf("  -d         write Gray-code deltas (position, new symbol) instead of full records\n");
+    printf("  -j threads format records on this many threads\n");
+    printf("  -s sink    write to a file, discard the output, or gzip it into <output>.gz\n");
+    printf("  -x file    expand a delta file back into full Gray-ordered records\n");
+    printf("  -o output  output file (default " DEFAULT_OUTPUT ")\n");
+    printf("  -B         benchmark every combination of the comma-separated -n, -r,\n");
+    printf("             -f (lex,gray,delta), -s and -j lists and print one JSON line per run\n");
+}
+
+int init_enumerator(Enumerator *e, int n, int radix, int order) {
+    e->n = n;
+    e->radix = radix;
+    e->order = order;
+    for (int j = 0; j < n; j++) {
+        e->b[j] = 0;
+        e->g[j] = 0;
+        e->dir[j] = 1;
+    }
+    return 0;
+}
+
+// Position the enumerator on an arbitrary record so blocks can be generated
+// independently. A Gray digit runs downwards whenever the number formed by
+// the higher counter digits is odd.
+void seek_enumerator(Enumerator *e, unsigned long long row) {
+    unsigned long long q = row;
+    for (int j = 0; j < e->n; j++) {
+        e->b[j] = (int)(q % (unsigned long long)e->radix);
+        q /= (unsigned long long)e->radix;
+        e->dir[j] = (q & 1) ? -1 : 1;
+        e->g[j] = (e->dir[j] > 0) ? e->b[j] : e->radix - 1 - e->b[j];
+    }
+}
+
+// Advance to the next record. Returns the changed digit in Gray order
+// (exactly one digit moves by one), or the highest changed digit otherwise.
+int step_enumerator(Enumerator *e) {
+    int j = 0;
+    while (j < e->n && e->b[j] == e->radix - 1) {
+        // Wrapping digits stay put in Gray order and reverse direction
+        e->b[j] = 0;
+        e->dir[j] = -e->dir[j];
+        j++;
+    }
+    if (j == e->n) {
+        return -1;
+    }
+    e->b[j]++;
+    e->g[j] += e->dir[j];
+    return j;
+}
+
+void render_record(const Enumerator *e, char *out) {
+    const int *digits = (e->order == ORDER_GRAY) ? e->g : e->b;
+    for (int col = e->n - 1; col >= 0; col--) {
+        *out++ = a[digits[col]];
+    }
+}
+
+size_t block_capacity(const GenConfig *cfg) {
+    // "\nF<id>\n" + cells, or "<position> <symbol>\n" for deltas
+    return (size_t)BLOCK_ROWS * (size_t)(cfg->n + 32);
+}
+
+// Format records [start, end) into out and return the number of bytes.
+// Delta blocks emit the change that leads into each of their records, so
+// they never contain record 0 (that one is written with the header).
+size_t format_block(const GenConfig *cfg, unsigned long long start, unsigned long long end, char *out) {
+    Enumerator e;
+    init_enumerator(&e, cfg->n, cfg->radix, cfg->format == FORMAT_LEX ? ORDER_LEXICOGRAPHIC : ORDER_GRAY);
+    size_t used = 0;
+
+    if (cfg->format == FORMAT_DELTA) {
+        seek_enumerator(&e, start - 1);
+        for (unsigned long long row = start; row < end; row++) {
+            int j = step_enumerator(&e);
+            used += sprintf(out + used, "%d ", cfg->n - 1 - j);
+            out[used++] = a[e.g[j]];
+            out[used++] = '\n';
+        }
+    } else {
+        seek_enumerator(&e, start);
+        for (unsigned long long row = start; row < end; row++) {
+            if (row > start) {
+                step_enumerator(&e);
+            }
+            used += sprintf(out + used, "\nF%llu\n", row + 1);
+            render_record(&e, out + used);
+            used += cfg->n;
+        }
+    }
+    return used;
+}
+
+void* block_worker(void *arg) {
+    BlockQueue *q = (BlockQueue*)arg;
+
+    pthread_mutex_lock(&q->lock);
+    while (q->next_block < q->nblocks) {
+        unsigned long long block = q->next_block++;
+        int slot = (int)(block % (unsigned long long)q->nslots);
+
+        // Wait for the writer to drain the block that used this slot before
+        while (block >= q->written_block + (unsigned long long)q->nslots) {
+            pthread_cond_wait(&q->changed, &q->lock);
+        }
+        pthread_mutex_unlock(&q->lock);
+
+        unsigned long long start = q->first_row + block * BLOCK_ROWS;
+        unsigned long long end = start + BLOCK_ROWS;
+        if (end > q->last_row) {
+            end = q->last_row;
+        }
+        size_t len = format_block(q->cfg, start, end, q->slot_data[slot]);
+
+        pthread_mutex_lock(&q->lock);
+        q->slot_len[slot] = len;
+        q->slot_block[slot] = block;
+        pthread_cond_broadcast(&q->changed);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return NULL;
+}
+
+int open_sink(Sink *sink, int kind, const char *path, int binary) {
+    sink->kind = kind;
+    sink->fp = NULL;
+    sink->bytes = 0;
+
+    if (kind == SINK_NULL) {
+        return 0;
+    }
+    if (kind == SINK_GZIP) {
+        char command[512];
+        snprintf(command, sizeof(command), "gzip -c > \"%s.gz\"", path);
+        sink->fp = popen(command, binary ? "wb" : "w");
+    } else {
+        sink->fp = fopen(path, binary ? "wb" : "w");
+    }
+    return sink->fp == NULL ? 1 : 0;
+}
+
+void sink_write(Sink *sink, const char *data, size_t len) {
+    sink->bytes += len;
+    if (sink->fp != NULL) {
+        fwrite(data, 1, len, sink->fp);
+    }
+}
+
+int close_sink(Sink *sink) {
+    int result = 0;
+    if (sink->kind == SINK_GZIP) {
+        result = pclose(sink->fp) != 0;
+    } else if (sink->fp != NULL) {
+        result = fclose(sink->fp) != 0;
+    }
+    sink->fp = NULL;
+    return result;
+}
+
+// Write every (k+1)^n record, either as full "F<id>" records or as a Gray
+// delta stream: a header, the first record and then one "<position> <symbol>"
+// line per record, where position 0 is the leftmost cell.
+int generate(Sink *sink, const GenConfig *cfg) {
+    int k = cfg->radix - 1;
+    unsigned long long nbr_comb = 1;
+    for (int i = 0; i < cfg->n; i++) {
+        nbr_comb *= (unsigned long long)cfg->radix;
+    }
+
+    char line[256];
+    BlockQueue q;
+    memset(&q, 0, sizeof(q));
+    q.cfg = cfg;
+    q.first_row = 0;
+    q.last_row = nbr_comb;
+
+    if (cfg->format == FORMAT_DELTA) {
+        Enumerator e;
+        init_enumerator(&e, cfg->n, cfg->radix, ORDER_GRAY);
+        int len = snprintf(line, sizeof(line), "GRAYDELTA k=%d n=%d count=%llu\n", k, cfg->n, nbr_comb);
+        render_record(&e, line + len);
+        len += cfg->n;
+        line[len++] = '\n';
+        sink_write(sink, line, len);
+        q.first_row = 1;
+    }
+
+    q.nblocks = (q.last_row - q.first_row + BLOCK_ROWS - 1) / BLOCK_ROWS;
+    int threads = cfg->threads < 1 ? 1 : cfg->threads;
+    q.nslots = threads == 1 ? 1 : threads * 2;
+    q.slot_data = calloc(q.nslots, sizeof(char*));
+    q.slot_len = calloc(q.nslots, sizeof(size_t));
+    q.slot_block = calloc(q.nslots, sizeof(unsigned long long));
+    if (q.slot_data == NULL || q.slot_len == NULL || q.slot_block == NULL) {
+        printf("Error allocating output buffer.\n");
+        return 1;
+    }
+    for (int i = 0; i < q.nslots; i++) {
+        q.slot_data[i] = malloc(block_capacity(cfg));
+        q.slot_block[i] = ~0ULL;
+        if (q.slot_data[i] == NULL) {
+            printf("Error allocating output buffer.\n");
+            return 1;
+        }
+    }
+
+    if (threads == 1) {
+        for (unsigned long long block = 0; block < q.nblocks; block++) {
+            unsigned long long start = q.first_row + block * BLOCK_ROWS;
+            unsigned long long end = start + BLOCK_ROWS < q.last_row ? start + BLOCK_ROWS : q.last_row;
+            size_t len = format_block(cfg, start, end, q.slot_data[0]);
+            sink_write(sink, q.slot_data[0], len);
+        }
+    } else {
+        pthread_t workers[MAX_THREADS];
+        pthread_mutex_init(&q.lock, NULL);
+        pthread_cond_init(&q.changed, NULL);
+        for (int i = 0; i < threads; i++) {
+            pthread_create(&workers[i], NULL, block_worker, &q);
+        }
+
+        // Flush blocks strictly in order while the workers run ahead
+        pthread_mutex_lock(&q.lock);
+        while (q.written_block < q.nblocks) {
+            int slot = (int)(q.written_block % (unsigned long long)q.nslots);
+            while (q.slot_block[slot] != q.written_block) {
+                pthread_cond_wait(&q.changed, &q.lock);
+            }
+            pthread_mutex_unlock(&q.lock);
+            sink_write(sink, q.slot_data[slot], q.slot_len[slot]);
+            pthread_mutex_lock(&q.lock);
+            q.slot_block[slot] = ~0ULL;
+            q.written_block++;
+            pthread_cond_broadcast(&q.changed);
+        }
+        pthread_mutex_unlock(&q.lock);
+
+        for (int i = 0; i < threads; i++) {
+            pthread_join(workers[i], NULL);
+        }
+        pthread_mutex_destroy(&q.lock);
+        pthread_cond_destroy(&q.changed);
+    }
+
+    for (int i = 0; i < q.nslots; i++) {
+        free(q.slot_data[i]);
+    }
+    free(q.slot_data);
+    free(q.slot_len);
+    free(q.slot_block);
+
+    int len;
+    if (cfg->format == FORMAT_DELTA) {
+        len = snprintf(line, sizeof(line), "End.\n");
+    } else {
+        len = snprintf(line, sizeof(line), "\n\nEnd.(k+1)^n = (%d + 1)^%d = %llu\n", k, cfg->n, nbr_comb);
+    }
+    sink_write(sink, line, len);
+    return 0;
+}
+
+// Stream a delta file back into the full record format written by -g
+int expand_delta(FILE *in, FILE *out) {
+    int k, n;
+    unsigned long long count;
+    if (fscanf(in, "GRAYDELTA k=%d n=%d count=%llu", &k, &n, &count) != 3 || fgetc(in) != '\n') {
+        printf("Error: not a Gray delta file.\n");
+        return 1;
+    }
+    if (n < 1 || n > MAX_CELLS) {
+        printf("Error: unsupported number of cells %d.\n", n);
+        return 1;
+    }
+
+    char record[MAX_CELLS];
+    if (fread(record, 1, n, in) != (size_t)n || fgetc(in) != '\n') {
+        printf("Error: truncated delta file.\n");
+        return 1;
+    }
+
+    unsigned long long id = 1;
+    fprintf(out, "\nF%llu\n", id);
+    fwrite(record, 1, n, out);
+
+    for (unsigned long long row = 1; row < count; row++) {
+        int pos;
+        if (fscanf(in, "%d", &pos) != 1 || fgetc(in) != ' ') {
+            printf("Error: malformed delta at record %llu.\n", row + 1);
+            return 1;
+        }
+        int symbol = fgetc(in);
+        if (symbol == EOF || fgetc(in) != '\n' || pos < 0 || pos >= n) {
+            printf("Error: malformed delta at record %llu.\n", row + 1);
+            return 1;
+        }
+        record[pos] = (char)symbol;
+        id++;
+        fprintf(out, "\nF%llu\n", id);
+        fwrite(record, 1, n, out);
+    }
+
+    fprintf(out, "\n\nEnd.(k+1)^n = (%d + 1)^%d = %llu\n", k, n, id);
+    return 0;
+}
+
+// Whether radix^n records fit in the record counter
+int records_fit(int n, int radix) {
+    unsigned long long limit = 1;
+    for (int i = 0; i < n; i++) {
+        if (limit > ~0ULL / (unsigned long long)radix) {
+            return 0;
+        }
+        limit *= (unsigned long long)radix;
+    }
+    return 1;
+}
+
+// Parse "2,3,4" into values; returns the number of values or -1
+int parse_list(const char *text, int *values, int max) {
+    int count = 0;
+    const char *p = text;
+    while (*p) {
+        char *end;
+        long v = strtol(p, &end, 10);
+        if (end == p || count == max || (*end != ',' && *end != '\0')) {
+            return -1;
+        }
+        values[count++] = (int)v;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    return count;
+}
+
+// Parse "lex,delta" against a name table; returns the number of values or -1
+int parse_names(const char *text, const char **names, int count, int *values, int max) {
+    int found = 0;
+    const char *p = text;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        int match = -1;
+        for (int i = 0; i < count; i++) {
+            if (strlen(names[i]) == len && strncmp(p, names[i], len) == 0) {
+                match = i;
+            }
+        }
+        if (match < 0 || found == max) {
+            return -1;
+        }
+        values[found++] = match;
+        p += len;
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return found;
+}
+
+#ifndef _WIN32
+// Run each configuration in a child process so wait4() reports its own CPU
+// time and peak RSS (including a gzip sink it waited for), and print one
+// JSON object per run.
+int run_benchmark(FILE *report, const int *ns, int nn, const int *radices, int nr,
+                  const int *formats, int nf, const int *sinks, int nsk, const int *threads, int nt) {
+    for (int in = 0; in < nn; in++)
+    for (int ir = 0; ir < nr; ir++)
+    for (int iff = 0; iff < nf; iff++)
+    for (int is = 0; is < nsk; is++)
+    for (int it = 0; it < nt; it++) {
+        GenConfig cfg = { ns[in], radices[ir], formats[iff], sinks[is], threads[it] };
+        unsigned long long records = 1;
+        for (int i = 0; i < cfg.n; i++) {
+            records *= (unsigned long long)cfg.radix;
+        }
+
+        int fds[2];
+        if (pipe(fds) != 0) {
+            printf("Error creating pipe.\n");
+            return 1;
+        }
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        pid_t pid = fork();
+        if (pid < 0) {
+            printf("Error starting benchmark run.\n");
+            return 1;
+        }
+        if (pid == 0) {
+            close(fds[0]);
+            Sink sink;
+            int result = open_sink(&sink, cfg.sink, BENCH_SCRATCH, cfg.format == FORMAT_DELTA);
+            if (result == 0) {
+                result = generate(&sink, &cfg);
+                result |= close_sink(&sink);
+            }
+            ssize_t ignored = write(fds[1], &sink.bytes, sizeof(sink.bytes));
+            (void)ignored;
+            _exit(result);
+        }
+
+        close(fds[1]);
+        unsigned long long bytes = 0;
+        if (read(fds[0], &bytes, sizeof(bytes)) != (ssize_t)sizeof(bytes)) {
+            bytes = 0;
+        }
+        close(fds[0]);
+
+        int status = 0;
+        struct rusage usage;
+        wait4(pid, &status, 0, &usage);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+        double user = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6;
+        double sys = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+        int exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+
+        fprintf(report,
+                "{\"n\":%d,\"radix\":%d,\"format\":\"%s\",\"sink\":\"%s\",\"threads\":%d,"
+                "\"records\":%llu,\"bytes\":%llu,\"wall_s\":%.6f,\"user_s\":%.6f,\"sys_s\":%.6f,"
+                "\"records_per_s\":%.1f,\"bytes_per_s\":%.1f,\"peak_rss_kb\":%ld,\"exit\":%d}\n",
+                cfg.n, cfg.radix, format_names[cfg.format], sink_names[cfg.sink], cfg.threads,
+                records, bytes, wall, user, sys,
+                wall > 0 ? records / wall : 0.0, wall > 0 ? bytes / wall : 0.0,
+                usage.ru_maxrss, exit_code);
+        fflush(report);
+
+        remove(BENCH_SCRATCH);
+        remove(BENCH_SCRATCH ".gz");
+    }
+    return 0;
+}
+#else
+int run_benchmark(FILE *report, const int *ns, int nn, const int *radices, int nr,
+                  const int *formats, int nf, const int *sinks, int nsk, const int *threads, int nt) {
+    printf("Benchmark mode needs fork() and wait4() and is not available on Windows.\n");
+    return 1;
+}
+#endif
+
+int main(int argc, char *argv[]) {
     // Code adapted by DAC from lynn on https://stackoverflow.com
 
     // k is the exponent + number of cells
     // k+1 values must perfectly fill the size of the set of elements in question
 
-    FILE *fp = fopen("SOLUTION_RENAME.txt", "w");
-    if (fp == NULL) {
-        printf("Error opening file.\n");
+    // Single values in normal mode, comma-separated grids in benchmark mode
+    int ns[MAX_BENCH_VALUES] = { 2, 3, 4 };
+    int radices[MAX_BENCH_VALUES] = { 10, (int)strlen(a) };
+    int formats[MAX_BENCH_VALUES] = { FORMAT_LEX, FORMAT_GRAY, FORMAT_DELTA };
+    int sinks[MAX_BENCH_VALUES] = { SINK_FILE, SINK_NULL, SINK_GZIP };
+    int threads[MAX_BENCH_VALUES] = { 1, 2, 4 };
+    int nn = -1, nr = -1, nf = -1, nsk = -1, nt = -1;
+
+    int order = ORDER_LEXICOGRAPHIC;
+    int delta = 0;
+    int bench = 0;
+    const char *output = NULL;
+    const char *expand = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            nn = parse_list(argv[++i], ns, MAX_BENCH_VALUES);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            nr = parse_list(argv[++i], radices, MAX_BENCH_VALUES);
+        } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            nt = parse_list(argv[++i], threads, MAX_BENCH_VALUES);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            nsk = parse_names(argv[++i], sink_names, 3, sinks, MAX_BENCH_VALUES);
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            nf = parse_names(argv[++i], format_names, 3, formats, MAX_BENCH_VALUES);
+        } else if (strcmp(argv[i], "-g") == 0) {
+            order = ORDER_GRAY;
+        } else if (strcmp(argv[i], "-d") == 0) {
+            order = ORDER_GRAY;  // deltas are only one cell wide in Gray order
+            delta = 1;
+        } else if (strcmp(argv[i], "-B") == 0) {
+            bench = 1;
+        } else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+            expand = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (nn == 0 || nr == 0 || nf == 0 || nsk == 0 || nt == 0 ||
+        (!bench && (nn > 1 || nr > 1 || nf >= 0 || nsk > 1 || nt > 1))) {
+        usage(argv[0]);
         return 1;
     }
+    int given_n = nn > 0;
+    int given_r = nr > 0;
+    int given_s = nsk > 0;
+    int given_j = nt > 0;
+    if (nn < 0) nn = 3;
+    if (nr < 0) nr = 2;
+    if (nf < 0) nf = 3;
+    if (nsk < 0) nsk = 3;
+    if (nt < 0) nt = 3;
+
+    for (int i = 0; i < nr; i++) {
+        if (radices[i] < 2 || radices[i] > (int)strlen(a)) {
+            printf("Error: radix must be between 2 and %d.\n", (int)strlen(a));
+            return 1;
+        }
+    }
+    for (int i = 0; i < nt; i++) {
+        if (threads[i] < 1 || threads[i] > MAX_THREADS) {
+            printf("Error: threads must be between 1 and %d.\n", MAX_THREADS);
+            return 1;
+        }
+    }
+
+    if (bench) {
+        for (int i = 0; i < nn; i++) {
+            if (ns[i] < 1 || ns[i] > MAX_CELLS) {
+                printf("Error: n must be between 1 and %d.\n", MAX_CELLS);
+                return 1;
+            }
+            for (int j = 0; j < nr; j++) {
+                if (!records_fit(ns[i], radices[j])) {
+                    printf("Error: (k+1)^n is too large for n = %d and radix %d.\n", ns[i], radices[j]);
+                    return 1;
+                }
+            }
+        }
+        FILE *report = output ? fopen(output, "w") : stdout;
+        if (report == NULL) {
+            printf("Error opening file %s.\n", output);
+            return 1;
+        }
+        int result = run_benchmark(report, ns, nn, radices, nr, formats, nf, sinks, nsk, threads, nt);
+        if (report != stdout) {
+            fclose(report);
+        }
+        return result;
+    }
+
+    if (output == NULL) {
+        output = DEFAULT_OUTPUT;
+    }
+
+    if (expand != NULL) {
+        FILE *in = fopen(expand, "rb");
+        if (in == NULL) {
+            printf("Error opening file %s.\n", expand);
+            return 1;
+        }
+        FILE *fp = fopen(output, "w");
+        if (fp == NULL) {
+            printf("Error opening file.\n");
+            fclose(in);
+            return 1;
+        }
+        int result = expand_delta(in, fp);
+        fclose(in);
+        fclose(fp);
+        return result;
+    }
 
-    //char a[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 \t\n";
-    char a[] = 
-    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
-    "!\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~"
-    " \t\n\r\f\v"
-    ;
+    GenConfig cfg;
+    cfg.radix = given_r ? radices[0] : (int)strlen(a);
+    cfg.format = delta ? FORMAT_DELTA : (order == ORDER_GRAY ? FORMAT_GRAY : FORMAT_LEX);
+    cfg.sink = given_s ? sinks[0] : SINK_FILE;
+    cfg.threads = given_j ? threads[0] : 1;
 
-    int k = strlen(a) - 1;
+    int k = cfg.radix - 1;
     printf("k = %d;\n", k);
-    
-    int noc;
-    printf("n = ");
-    scanf("%d", &noc);
-    printf("\nNumber Of FILE Cells = %d\n", noc);
-    
-    int n = noc;
-    int row, col;
-    int rdiv;
-    int id = 0;
-    int nbr_comb = pow(k + 1, n);
-    
-    for (row = 0; row < nbr_comb; row++) {
-        id++;
-        fprintf(fp, "\nF%d\n", id);
-        
-        for (col = n - 1; col >= 0; col--) {
-            rdiv = pow(k + 1, col);
-            int cell = (row / rdiv) % (k + 1);
-            fprintf(fp, "%c", a[cell]);
+
+    int noc = ns[0];
+    if (!given_n) {
+        printf("n = ");
+        if (scanf("%d", &noc) != 1) {
+            printf("Invalid input.\n");
+            return 1;
         }
     }
+    printf("\nNumber Of FILE Cells = %d\n", noc);
 
-    fprintf(fp, "\n\nEnd.(k+1)^n = (%d + 1)^%d = %d\n", k, n, id);
-    fclose(fp);
-    
-    return 0;
+    if (noc < 1 || noc > MAX_CELLS) {
+        printf("Error: n must be between 1 and %d.\n", MAX_CELLS);
+        return 1;
+    }
+
+    // (k+1)^n must fit in the record counter
+    if (!records_fit(noc, k + 1)) {
+        printf("Error: (k+1)^n is too large for n = %d.\n", noc);
+        return 1;
+    }
+    cfg.n = noc;
+
+    // Delta records carry raw symbols (including \n and \r), so keep them binary
+    Sink sink;
+    if (open_sink(&sink, cfg.sink, output, cfg.format == FORMAT_DELTA) != 0) {
+        printf("Error opening file.\n");
+        return 1;
+    }
+
+    int result = generate(&sink, &cfg);
+    result |= close_sink(&sink);
+
+    return result;
 }
\ No newline at end of file
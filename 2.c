@@ -1,31 +1,161 @@
 //gcc main.c -o homeGame -I"C:/Users/dacoo/raylib/src" -L"C:/Users/dacoo/raylib/src" -lraylib -lopengl32 -lgdi32 -lwinmm -lm -lpthread
+#ifdef __linux__
+#define _GNU_SOURCE  // pipe2 and F_SETPIPE_SZ
+#endif
 #include "raylib.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <ctype.h>
+#include <time.h>
 #include <sys/stat.h>
+#include <dirent.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 
 #ifdef _WIN32
 #include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
 #define mkdir _mkdir  // Windows-specific mkdir alias
+#else
+#include <spawn.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/mman.h>
+#include <utime.h>
+#include <signal.h>
+#endif
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/syscall.h>
 #endif
 
-#define GRID_ROWS 5
+#include "registry.h"
+
+#define GRID_ROWS 5   // default grid size, -g COLSxROWS overrides
 #define GRID_COLS 5
-#define BUTTON_SIZE 100
-#define MAX_SCRIPTS 25
-#define MAX_TEXT_LENGTH 512
-#define MAX_GRIDS 200
+#define BUTTON_SIZE 100  // cell size at zoom 1
+#define MAX_GRID_SIDE 1000
+#define MIN_ZOOM 0.1f
+#define MAX_ZOOM 2.0f
+#define SCROLL_SPEED 15.0f  // how fast the view eases toward its target, per second
+#define SEARCH_QUERY_LENGTH 128
+#define EDITOR_FONT_SIZE 20
+#define EDITOR_LINE_HEIGHT 22
+#define EDITOR_GUTTER 60       // line numbers left of the text
+#define EDITOR_TAB_WIDTH 4
+#define EDITOR_GAP_SIZE 4096   // room left for typing when a file is opened
+#define CONSOLE_HEIGHT 220  // space kept below the grid for the console
+#define PANEL_WIDTH 210     // space kept right of the grid for the feedback panel
+#define MIN_GRIDS 1             // grids shown even with an empty gameFiles/
+#define MAX_SCRIPT_NUMBER 100000000
+#define INITIAL_SLOT_CAPACITY 1024  // slot table size before the first growth, power of two
+#define TEXT_CACHE_BYTES (16 * 1024 * 1024)  // script text kept in memory, least recently used goes first
 #define GAME_FILES_PATH "gameFiles/"
+#define BUILD_CACHE_PATH GAME_FILES_PATH ".build/"  // compiled scripts, one per content hash
+#define BUILD_CACHE_BYTES (256LL * 1024 * 1024)  // executables kept there, least recently used goes first
+#define C_COMPILER "gcc"
+#define C_FLAGS ""
+#define MAX_INCLUDE_DEPTH 8
+#define STATUS_POLL_FRAMES 60  // status refresh interval where inotify is unavailable
+#define IDLE_DELAY_SECONDS 0.5  // stop redrawing this long after the last change
+#define IDLE_WAIT_MS 50         // idle sleep, bounds how late input is noticed
+#define LOAD_QUEUE_SIZE 16      // pending grid loads for the background loader
+#define MAX_COMPILE_WORKERS 64  // C scripts compiled concurrently, one per core up to this
+#define COMPILE_ERROR_LENGTH 4096
+#define DEFAULT_MAX_PROCESSES 8  // scripts running at once, -j overrides
+#define MAX_PROCESS_LIMIT 64
+#define MAX_PROCESS_JOBS 256     // queued + running + finished handles kept
+#define MAX_PROCESS_ARGS 8
+#define RUN_HISTORY_PATH GAME_FILES_PATH ".history"  // binary log of finished runs
+#define RUN_HISTORY_LENGTH 16    // recent runs per script shown on its button
+#define RUN_HISTORY_MAX_BYTES (1024 * 1024)  // log is cut to its newest half past this at startup
+#define SLOW_RUN_SECONDS 2.0f    // runs this long or longer show fully red
+#define SCRIPT_PACK_PATH GAME_FILES_PATH "scripts.pack"  // optional packed store, see --pack
+#define BATCH_REPORT_PATH "report.json"  // --run results unless --report names another file
+#define MAX_PIPELINE_STAGES 8
+#define PIPE_BUFFER_BYTES (1024 * 1024)  // between pipeline stages, where the kernel allows it
+#define PROFILE_FRAMES 1024      // drawn frames kept for the profiler, about 17 s at 60 fps
+#define PROFILE_SPANS 1024       // finished compiles and runs kept for the trace
+#define PROFILE_TRACE_SECONDS 10 // how far back F4 writes the trace
+#define PROFILE_TRACE_PATH "trace.json"
+#define CHAR_MAP_ROLE "mapping file"   // 0.txt role of the character map for encoded scripts, --map overrides
+#define CHAR_MAP_ID 1                  // used when 0.txt has no such role
+#define MAX_CHAR_MAP 256
+#define EDITOR_PROGRAM "notepad"
+#define PYTHON_PROGRAM "python"
+#define MAX_PYTHON_WORKERS 16     // warm interpreters, -w picks how many (0 = off)
+#define OUTPUT_RING_SIZE 65536   // per-job output ring, power of two
+#define OUTPUT_CHUNK 4096        // largest read from a script's pipe
+#define MAX_OUTPUT_STREAMS 128   // pipes watched by the output reader
+#define MAX_ACTIVE_OUTPUTS 256   // rings the frame loop is still draining
+#define CONSOLE_MAX_LINES 1000   // scrollback per script
+#define CONSOLE_LINE_LENGTH 256
+#define CONSOLE_FONT_SIZE 16
+#define CONSOLE_LINE_HEIGHT 18
+
+// Output streams, also used as the chunk tag inside an output ring
+#define STREAM_STDOUT 1
+#define STREAM_STDERR 2
+
+// Process job states
+#define PROCESS_FREE 0
+#define PROCESS_QUEUED 1
+#define PROCESS_RUNNING 2
+#define PROCESS_DONE 3
+
+// Compile state shown on C script buttons
+#define COMPILE_IDLE 0
+#define COMPILE_BUSY 1
+#define COMPILE_OK 2
+#define COMPILE_FAILED 3
+
+// File status flags, one entry per script number
+#define STATUS_PY 1
+#define STATUS_C 2
+#define RUN_TIMED_OUT 1  // RunRecord flags
+#define RUN_WARM 2       // ran on a warm Python worker, wall time only
+#define PACK_PY 0        // PackEntry kinds, one per file a slot can have
+#define PACK_C 1
+#define PACK_PY_DESCRIPTION 2
+#define PACK_C_DESCRIPTION 3
+#define BATCH_WAITING 0  // BatchItem states
+#define BATCH_BUILDING 1
+#define BATCH_RUNNING 2
+#define BATCH_DONE 3
 
 // Function declarations
 void SaveScriptToFile(const char* filename, const char* text);
-void LoadScriptFromFile(const char* filename, char* textBuffer, int bufferSize);
+char* LoadScriptFromFile(const char* filename, size_t* length);
 bool DoesFileExist(const char* filename);
-void* ExecuteCommand(void* arg);
-void RunCommandAsync(const char* command);
+int ParseScriptFilename(const char* filename, bool* isC);
+void RefreshFileStatus(int scriptNumber);
+int ParsePackFilename(const char* filename, int* kind);
+void PackFilename(int scriptNumber, int kind, char* filename, size_t size);
+bool OpenScriptPack();
+const struct PackEntry* FindPackEntry(int scriptNumber, int kind);
+bool ExtractPackedFile(const char* filename);
+int PackGameFiles();
+int UnpackGameFiles();
+int CompactScriptPack();
+void RefreshFileStatusForPath(const char* filename);
+void StartFileWatcher();
+bool PollFileWatcher();
+int RunScriptProcess(const char* const* argv, int scriptNumber);
+void StartPythonWorkers();
+int GetProcessState(int handle, int* exitCode);
+int GetProcessTimes(int handle, double* startedAt, double* finishedAt);
+void StartProcessPool();
+void StartQueuedProcesses();
+void* ProcessReaperThread(void* arg);
 void OpenScriptInNotepad(const char* filename);
 void ExecutePythonScript(const char* filename);
 void CompileAndExecuteCFile(const char* filename);
@@ -37,21 +167,555 @@ void ToggleEditMode();
 void DrawHelpMenu();
 void DrawFeedbackPanel();
 void InitializeAndLoadExistingScripts();
+void ScanGameFiles();
+void StartScriptLoader();
+void RequestGridLoad(int gridIndex);
+void* ScriptLoaderThread(void* arg);
+void StartCompileWorkers();
+void PruneBuildCache();
+void* CompileWorkerThread(void* arg);
+bool PollCompileJobs();
+void WakeFrameLoop();
+void WaitForActivity(int timeoutMs);
+#ifndef _WIN32
+int OpenPipe(int fds[2]);
+#endif
+bool InputActivity();
+unsigned long long HashBytes(unsigned long long hash, const void* data, size_t length);
+unsigned long long GridSignature(int gridIndex);
+void DrawGridLayer();
+bool UpdateGridView(int screenWidth, int screenHeight);
+void GetVisibleCells(int* firstCol, int* lastCol, int* firstRow, int* lastRow);
+int CellAt(Vector2 point);
+Rectangle CellRect(int index);
+void ZoomGridView(float factor, Vector2 anchor);
+bool RescanGameFiles();
+void StartSearchIndexer();
+void QueueIndexUpdate(int scriptNumber);
+void* SearchIndexThread(void* arg);
+int CompareUnsigned(const void* a, const void* b);
+int ExtractTrigrams(const char* text, size_t length, unsigned int** trigrams);
+struct PostingList* FindPostingList(unsigned int trigram, bool create);
+void RunSearch();
+bool IsSearchMatch(int scriptNumber);
+void JumpToNextMatch();
+void HandleSearchInput();
+void DrawSearchBar(int screenWidth, int screenHeight);
+bool ContainsIgnoreCase(const char* text, const char* query);
+unsigned long long HashSourceTree(unsigned long long hash, const char* path, int depth);
+int CountProcessors();
+double NowSeconds();
+bool QueueCompileJob(int scriptNumber, const char* source, bool buildOnly, bool batch);
+int BuildAllScripts(int gridIndex);
+void FinishBuildReport();
+int BuildAllHeadless();
+int RunBatchHeadless(const char* spec, const char* reportPath);
+int ParseRunSpec(const char* spec, int** numbers);
+bool IsOutputPending(int handle);
+int ProfiledStat(const char* path, struct stat* buffer);
+FILE* ProfiledFopen(const char* path, const char* mode);
+void ProfileFrame(double start, double logicEnd, double drawEnd, double end);
+void ProfileSpan(int scriptNumber, bool compile, double start, double end);
+void DrawProfilerHud(int screenWidth);
+bool WriteProfileTrace(const char* path, double seconds);
+int CompareFloats(const void* a, const void* b);
+bool LoadCharMap(const char* path);
+char* DecodeScriptFile(const char* path, size_t* length);
+int ParseEncodedFilename(const char* filename, bool* isC);
+unsigned long long HashSourceText(unsigned long long hash, const char* directory, char* text, size_t length, int depth);
+int RunWithInput(const char* command, const char* input, size_t length, char* output, size_t size);
+int RunScriptWithInput(const char* const* argv, int scriptNumber, char* input, size_t length);
+bool OpenEditor(const char* filename, int scriptNumber);
+void CloseEditor();
+bool SaveEditor();
+void HandleEditorInput(int screenHeight);
+void DrawEditor(int screenWidth, int screenHeight);
+bool EditorKeyRepeat(int key);
+void EditorMoveTo(size_t position);
+void EditorInsert(const char* text, size_t length);
+void EditorDelete(bool forward);
+void EditorScrollToCursor(int visibleLines);
+
+// In-memory view of gameFiles/, filled at startup and kept current by the
+// file watcher so drawing never has to stat() anything
+typedef struct {
+    unsigned char flags;
+    time_t mtime;
+} FileStatus;
+
+// Packed store layout: a 16-byte header (magic, version, offset of the
+// current table of contents), then records appended as [PackRecord][data]
+// and, after each append, a new table of contents: a 4-byte count, 4 bytes
+// of padding and the PackEntries sorted by slot and kind. Nothing is ever
+// rewritten except the header's offset, so a reader that mapped the file
+// earlier keeps seeing a consistent older table.
+typedef struct {
+    char magic[4];  // "SPK1"
+    uint32_t version;
+    uint64_t tocOffset;
+} PackHeader;
 
-// Define the structures and variables
 typedef struct {
-    char text[MAX_TEXT_LENGTH];
+    int32_t scriptNumber;
+    int32_t kind;    // PACK_*
+    uint32_t length;
+    uint32_t reserved;
+    int64_t mtime;   // of the loose file it was taken from
+} PackRecord;
+
+typedef struct PackEntry {
+    int32_t scriptNumber;
+    int32_t kind;
+    uint32_t length;
+    uint32_t reserved;
+    uint64_t offset;  // of the data, just past its PackRecord
+    int64_t mtime;
+} PackEntry;
+
+// Define the structures and variables. Scripts are allocated on first use
+// and never freed, so pointers to them stay valid.
+typedef struct Script {
+    char* text;  // full file contents, NULL until loaded or after eviction
+    size_t textLength;
     bool isEditing;
     char filename[50];
     bool isCFile;
+    int number;  // script number used in the filename (1-based)
+    bool textLoaded;  // text is read lazily once the grid is shown
+    int compileState;  // COMPILE_* for C scripts
+    int runJob;  // handle of the last process started for this script, 0 if none
+    struct Console* console;  // captured output, allocated on first run
+    FileStatus status;
+    struct Script* lruPrev;  // text cache order, most recently used first
+    struct Script* lruNext;
+    unsigned int* trigrams[2];  // search index entries of the .py [0] and .c [1] file
+    int trigramCount[2];
+    bool indexPending;          // queued for the search indexer
+    unsigned char indexFlags;   // status.flags when last queued, under indexQueueLock
+    float recentRuns[RUN_HISTORY_LENGTH];  // wall seconds, oldest first, under historyLock
+    int recentRunCount;
+    float buildSeconds;  // last compile of the C file, cache lookups included
+    char executable[100];  // last successful build, for pipeline stages
+    time_t textMtime;  // status.mtime when text was read
 } Script;
 
+// A queued gcc run; workers fill in exitCode and errors and hand the job
+// back to the frame loop through the completed list
+typedef struct CompileJob {
+    int scriptNumber;
+    char source[100];
+    char output[100];
+    bool cached;  // output came from the build cache, gcc was not run
+    bool buildOnly;  // not run afterwards
+    bool batch;      // part of the build-all batch, counted in its report
+    char* input;  // decoded source of an encoded script, fed to gcc on stdin
+    size_t inputLength;
+    double startedAt;  // NowSeconds() when a worker picked it up
+    double seconds;  // time spent hashing and compiling
+    int exitCode;
+    char errors[COMPILE_ERROR_LENGTH];
+    struct CompileJob* next;
+} CompileJob;
+
+// Single-producer/single-consumer byte ring between the output reader
+// thread (producer) and the frame loop (consumer). Data is framed as
+// [stream][length low][length high][bytes...] so stdout and stderr keep
+// their arrival order.
+typedef struct OutputRing {
+    char data[OUTPUT_RING_SIZE];
+    atomic_size_t head;     // advanced by the reader thread only
+    atomic_size_t tail;     // advanced by the frame loop only
+    atomic_int openStreams; // pipes not yet at EOF
+    atomic_bool closed;     // reader is done with this ring
+} OutputRing;
+
+// Scrollback shown in the console panel, owned by the frame loop
+typedef struct Console {
+    char* lines[CONSOLE_MAX_LINES];  // circular, oldest at first
+    bool isError[CONSOLE_MAX_LINES];
+    int first;
+    int count;
+    bool lineOpen;  // last line has not seen its newline yet
+    int scroll;     // lines scrolled up from the newest
+    bool truncated; // output was cut at CONSOLE_LINE_LENGTH or CONSOLE_MAX_LINES
+} Console;
+
+// A ring the frame loop still drains into a script's console
+typedef struct {
+    OutputRing* ring;
+    int scriptNumber;
+    int handle;  // the job writing into it, reported once it is reaped
+} ActiveOutput;
+
+// A pipe the reader thread is reading
+typedef struct {
+    int fd;
+    int stream;
+    OutputRing* ring;
+} OutputStream;
+
+// One finished run as stored in the history log, fixed size on disk
+typedef struct {
+    int32_t scriptNumber;
+    int32_t exitCode;
+    int64_t finishedAt;  // time() when it was reaped
+    float wallSeconds;
+    float cpuSeconds;    // user + system
+    int32_t maxRssKb;    // peak resident set size
+    int32_t flags;       // RUN_*
+} RunRecord;
+
+// One launched (or waiting) script process. Handles increase forever;
+// a handle maps to processJobs[handle % MAX_PROCESS_JOBS] while it is recent.
+typedef struct {
+    int handle;
+    int state;
+    int scriptNumber;
+    char* argv[MAX_PROCESS_ARGS + 1];
+    int exitCode;
+    OutputRing* output;  // where stdout/stderr go, NULL to inherit the terminal
+    bool warm;           // runs on a warm Python worker instead of its own process
+    double startedAt;    // NowSeconds() when it started running
+    double finishedAt;
+    RunRecord record;    // filled in when the job is reaped
+    bool pipelined;      // a pipeline stage: starts with its neighbours, ignoring -j
+    int stdinFd;         // pipe ends the child gets as stdin/stdout, -1 for the usual
+    int stdoutFd;
+#ifndef _WIN32
+    pid_t pid;
+    int pidfd;  // -1 when pidfd_open is unavailable
+#endif
+} ProcessJob;
+
+ProcessJob* ClaimProcessJob(const char* const* argv, int scriptNumber, OutputRing* output);
+int SubmitProcess(const char* const* argv, int scriptNumber, OutputRing* output);
+int SubmitWarmPython(const char* filename, int scriptNumber, OutputRing* output);
+bool ReapProcess(ProcessJob* job);
+void RecordRun(ProcessJob* job);
+void AddRunHistory(const RunRecord* record);
+void LoadRunHistory();
+char** LimitedArgv(ProcessJob* job, char** argv, char* script, size_t size);
+int GetProcessRecord(int handle, RunRecord* record);
+Color HeatColor(float seconds);
+void WriteJsonString(FILE* file, const char* text, bool errors, const Console* console);
+void TogglePipelineStage(int scriptNumber);
+int PipelineStageOf(int scriptNumber);
+bool StartPipeline(const int* stages, int count, bool headless);
+bool LaunchPipeline();
+bool PollPipeline();
+void FinishPipeline(const char* problem);
+int RunPipelineHeadless(const char* spec);
+bool OutputRingWrite(OutputRing* ring, int stream, const char* data, size_t length);
+size_t OutputRingSpace(OutputRing* ring);
+void RegisterOutputStreams(int outFd, int errFd, OutputRing* ring);
+void StartOutputReader();
+bool ReadFully(int fd, void* buffer, size_t length);
+int StartPythonInterpreter(int* toWorker, int* fromWorker);
+void* PythonWorkerThread(void* arg);
+void* OutputReaderThread(void* arg);
+bool PumpScriptOutput();
+void ConsoleAppend(Console* console, const char* data, size_t length, bool isError);
+Console* GetConsole(Script* script);
+void DrawConsolePanel(Script* script, int x, int y, int width, int height);
+Script* FindScript(int scriptNumber);
+Script* GetScript(int scriptNumber);
+Script* GetGridScript(int gridIndex, int index);
+void ChooseScriptFile(Script* script);
+bool ScriptFileExists(const Script* script);
+void LoadScriptText(Script* script);
+void SetScriptText(Script* script, char* text, size_t length);
+char* CopyScriptSource(Script* script, const char* filename, size_t* length);
+void TouchScriptText(Script* script);
+void DrawScriptButton(int index, bool selected);
+void DrawScriptStatus(int index);
+void IndexDocument(Script* script, int language, unsigned int* trigrams, int count);
+
+// The packed store, mapped once at startup and read-only afterwards
+const unsigned char* packData = NULL;
+size_t packSize = 0;
+const PackEntry* packEntries = NULL;
+uint32_t packEntryCount = 0;
+
+// Sparse slot table: script number -> Script, open addressing. Only slots
+// that have a file or have been shown on screen exist. slotLock guards the
+// table itself, not the scripts in it.
+pthread_mutex_t slotLock = PTHREAD_MUTEX_INITIALIZER;
+Script** slotTable = NULL;
+int slotCapacity = 0;
+int slotCount = 0;
+int gridCount = MIN_GRIDS;  // last grid holding a script, plus an empty one
+int watchFd = -1;
+int statusPollFrame = 0;
+
+// Idle frame pacing: worker threads set uiChanged (and poke the wake pipe)
+// whenever something on screen changes, so an idle frame loop can sleep
+atomic_bool uiChanged = true;
+#ifndef _WIN32
+int uiWakePipe[2] = { -1, -1 };
+#endif
+
+// Background loading of script contents, one grid at a time.
+// scriptTextLock guards Script.text, textLength, textLoaded and the LRU list,
+// and filename and isCFile, which the frame loop rewrites while loaders read them.
+pthread_mutex_t scriptTextLock = PTHREAD_MUTEX_INITIALIZER;
+Script* lruHead = NULL;
+Script* lruTail = NULL;
+size_t textCacheBytes = 0;
+pthread_mutex_t loadQueueLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t loadQueueReady = PTHREAD_COND_INITIALIZER;
+int loadQueue[LOAD_QUEUE_SIZE];
+int loadQueueCount = 0;
+
+// Trigram search index: for every lower-cased 3-byte sequence, the sorted
+// documents (script number * 2 + 1 for .c) that contain it. searchLock
+// guards the posting lists and Script.trigrams; the indexer thread reads
+// files without holding it.
+typedef struct PostingList {
+    unsigned int trigram;
+    int* documents;
+    int count;
+    int capacity;
+} PostingList;
+
+pthread_mutex_t searchLock = PTHREAD_MUTEX_INITIALIZER;
+PostingList* postingTable = NULL;
+int postingCapacity = 0;
+int postingCount = 0;
+pthread_mutex_t indexQueueLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t indexQueueReady = PTHREAD_COND_INITIALIZER;
+int* indexQueue = NULL;  // FIFO, indexQueueHead is the next to index
+int indexQueueHead = 0;
+int indexQueueCount = 0;
+int indexQueueCapacity = 0;
+atomic_bool searchIndexChanged = false;
+
+// Encoded scripts: gameFiles/scriptN.py.txt or scriptN.c.txt hold the
+// script as space-separated 1-based indices into the character map, as
+// 0.c writes them. They are decoded in memory only; a loose file of the
+// same script takes precedence.
+char charMap[MAX_CHAR_MAP];
+int charMapSize = 0;
+const char* charMapPath = NULL;  // NULL until resolved through the registry
+
+// Search box state, frame loop only
+bool searchActive = false;
+char searchQuery[SEARCH_QUERY_LENGTH] = "";
+int* searchResults = NULL;  // matching script numbers, ascending
+int searchResultCount = 0;
+double searchTimeMs = 0;
+
+// In-app editor. The text lives in a gap buffer: the bytes before the
+// cursor at the start of data, the bytes after it at the end, free space
+// (the gap) in between, so typing at the cursor never moves the rest.
+typedef struct {
+    char* data;
+    size_t capacity;
+    size_t gapStart;  // also the cursor
+    size_t gapEnd;
+} GapBuffer;
+
+typedef struct {
+    bool open;
+    GapBuffer buffer;
+    char filename[128];
+    int scriptNumber;   // 0 for a description file
+    bool dirty;
+    bool confirmClose;  // Esc pressed once with unsaved changes
+    int cursorLine;     // 0-based line of the cursor
+    size_t topOffset;   // first visible line, as an offset and a line number
+    int topLine;
+    size_t column;      // wanted column when moving up and down, or SIZE_MAX
+    int repeatKey;      // key being held for auto-repeat
+    double repeatAt;
+    char message[192];
+} Editor;
+Editor editor;
+
+// Compile worker pool: pending jobs in FIFO order, finished jobs waiting
+// for the frame loop
+pthread_mutex_t compileLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t compileReady = PTHREAD_COND_INITIALIZER;
+CompileJob* pendingHead = NULL;
+CompileJob* pendingTail = NULL;
+CompileJob* completedJobs = NULL;
+int compileWorkers = 1;
+int pendingCompileCount = 0;  // queue depth and busy workers, for the profiler
+int busyCompileWorkers = 0;
+
+// Build-all batch, owned by the frame loop. Results arrive in completion
+// order and are reported sorted by script number once all are in.
+typedef struct {
+    int scriptNumber;
+    int exitCode;
+    bool cached;
+    double seconds;
+    char error[256];  // first error line of a failed build
+} BuildResult;
+BuildResult* buildResults = NULL;
+int buildResultCount = 0;
+int buildBatchTotal = 0;
+int buildBatchFailed = 0;
+int buildBatchUpToDate = 0;
+int* buildSkipped = NULL;  // scripts left out because they were already compiling
+int buildSkippedCount = 0;
+bool buildBatchActive = false;
+double buildBatchStart = 0;
+// Bounded process pool. Jobs start in handle order while fewer than
+// maxRunningProcesses are running; processLock guards the table.
+pthread_mutex_t processLock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t processReady = PTHREAD_COND_INITIALIZER;
+ProcessJob processJobs[MAX_PROCESS_JOBS];
+int maxRunningProcesses = DEFAULT_MAX_PROCESSES;
+int nextProcessHandle = 1;
+int nextStartHandle = 1;
+int runningProcesses = 0;
+#ifndef _WIN32
+int processWakePipe[2] = { -1, -1 };
+#endif
+
+// Pipelines: scripts chained stdout to stdin, all stages running at once.
+// pipelineDraft is built with Ctrl+click; one pipeline runs at a time.
+typedef struct {
+    int stages[MAX_PIPELINE_STAGES];  // script numbers, data flows first to last
+    int handles[MAX_PIPELINE_STAGES];
+    int stageCount;
+    bool building;  // waiting for the C stages to compile
+    bool running;
+    bool headless;  // output goes to the terminal instead of the consoles
+    int exitCode;   // first failing stage's, like pipefail
+} Pipeline;
+Pipeline pipelineDraft;
+Pipeline activePipeline;
+
+// Limits for script processes, 0 = none: -t wall-clock timeout,
+// -c CPU seconds and -m memory in MB (both through setrlimit)
+double runTimeout = 0;
+int cpuLimitSeconds = 0;
+int memoryLimitMb = 0;
+
+// Run history: every reaped job is appended to RUN_HISTORY_PATH and to its
+// script's recentRuns. runHistoryVersion tells the grid layer to redraw.
+pthread_mutex_t historyLock = PTHREAD_MUTEX_INITIALIZER;
+FILE* historyFile = NULL;
+atomic_uint runHistoryVersion = 0;
+
+// Warm Python workers: long-lived interpreters that run one script at a
+// time in a fresh namespace. Their jobs live in processJobs with warm set
+// and are handed out through pythonWorkReady.
+int pythonWorkers = 0;
+pthread_cond_t pythonWorkReady = PTHREAD_COND_INITIALIZER;
+int nextWarmHandle = 1;
+
+// Profiler: every drawn frame and every finished compile or run goes into
+// a ring, whether or not the F3 overlay is showing, so F4 can write a
+// trace of the stutter that just happened. The call counters are bumped
+// from any thread and collected once per frame.
+typedef struct {
+    double start;     // NowSeconds()
+    float logicMs;    // input, polling and layout before BeginDrawing
+    float drawMs;     // building the frame
+    float frameMs;    // the whole iteration, waiting for the frame rate included
+    uint16_t stats;
+    uint16_t opens;
+    uint16_t spawns;
+    uint16_t compileQueue;
+    uint16_t compileBusy;
+    uint16_t runQueue;
+    uint16_t running;
+} ProfileFrameRecord;
+
 typedef struct {
-    Script scripts[MAX_SCRIPTS];
-    int gridID;
-} ScriptGrid;
+    double start;
+    double end;
+    int scriptNumber;
+    bool compile;
+} ProfileSpanRecord;
+
+atomic_uint statCalls = 0;
+atomic_uint fopenCalls = 0;
+atomic_uint spawnCalls = 0;
+ProfileFrameRecord profileFrames[PROFILE_FRAMES];
+int profileFrameCount = 0;  // total recorded, the ring holds the newest
+pthread_mutex_t profileLock = PTHREAD_MUTEX_INITIALIZER;  // guards the span ring
+ProfileSpanRecord profileSpans[PROFILE_SPANS];
+int profileSpanCount = 0;
+bool showProfiler = false;
+
+// Runs inside each worker. Reads one script path per line from stdin and
+// answers on the original stdout with frames of [tag][4-byte length][data]:
+// 'o' stdout, 'e' stderr, 'x' the exit status as a 4-byte integer.
+// Modules imported from the script's own directory are dropped after each
+// run so edits to helper files are picked up; everything else stays warm.
+const char* pythonWorkerSource =
+    "import os, sys, runpy, struct, traceback\n"
+    "proto = os.fdopen(os.dup(1), 'wb', 0)\n"
+    "os.dup2(2, 1)\n"
+    "def send(tag, data):\n"
+    "    proto.write(tag + struct.pack('<I', len(data)) + data)\n"
+    "class Stream:\n"
+    "    def __init__(self, tag): self.tag = tag\n"
+    "    def write(self, text):\n"
+    "        if text: send(self.tag, text.encode('utf-8', 'replace'))\n"
+    "        return len(text)\n"
+    "    def flush(self): pass\n"
+    "    def isatty(self): return False\n"
+    "home = os.getcwd()\n"
+    "for line in sys.stdin:\n"
+    "    path = line.rstrip('\\n')\n"
+    "    folder = os.path.dirname(os.path.abspath(path))\n"
+    "    before = set(sys.modules)\n"
+    "    saved = (sys.argv, list(sys.path), sys.stdin)\n"
+    "    sys.argv, sys.stdin = [path], open(os.devnull)\n"
+    "    sys.path.insert(0, folder)\n"
+    "    sys.stdout, sys.stderr = Stream(b'o'), Stream(b'e')\n"
+    "    code = 0\n"
+    "    try:\n"
+    "        runpy.run_path(path, run_name='__main__')\n"
+    "    except SystemExit as e:\n"
+    "        if isinstance(e.code, int): code = e.code\n"
+    "        elif e.code is not None: print(e.code, file=sys.stderr); code = 1\n"
+    "    except BaseException as e:\n"
+    "        tb = e.__traceback__\n"
+    "        while tb and tb.tb_frame.f_code.co_filename != path: tb = tb.tb_next\n"
+    "        traceback.print_exception(type(e), e, tb or e.__traceback__); code = 1\n"
+    "    sys.stdin.close()\n"
+    "    sys.argv, sys.path[:], sys.stdin = saved\n"
+    "    sys.stdout, sys.stderr = sys.__stdout__, sys.__stderr__\n"
+    "    for name in set(sys.modules) - before:\n"
+    "        where = getattr(sys.modules[name], '__file__', None) or ''\n"
+    "        if os.path.abspath(where).startswith(folder + os.sep): del sys.modules[name]\n"
+    "    os.chdir(home)\n"
+    "    send(b'x', struct.pack('=i', code))\n";
+
+// Output capture: rings being drained by the frame loop, and the pipes the
+// reader thread has yet to pick up (outputLock guards only the hand-over)
+ActiveOutput activeOutputs[MAX_ACTIVE_OUTPUTS];
+int activeOutputCount = 0;
+pthread_mutex_t outputLock = PTHREAD_MUTEX_INITIALIZER;
+OutputStream newOutputStreams[MAX_OUTPUT_STREAMS];
+int newOutputStreamCount = 0;
+int outputStreamCount = 0;  // handed over and not yet at EOF, at most MAX_OUTPUT_STREAMS
+int outputWakePipe[2] = { -1, -1 };
+
+char lastCompileError[256] = "";
+int lastCompileErrorScript = 0;  // script the error line above belongs to
+
+// Grid layout and the view onto it. Only cells inside gridView are drawn
+// or looked up; scroll eases toward targetScroll each frame.
+int gridCols = GRID_COLS;
+int gridRows = GRID_ROWS;
+int scriptsPerGrid = GRID_COLS * GRID_ROWS;
+Rectangle gridView = { 0, 0, GRID_COLS * BUTTON_SIZE, GRID_ROWS * BUTTON_SIZE };
+Vector2 scroll = { 0, 0 };
+Vector2 targetScroll = { 0, 0 };
+float zoom = 1.0f;
+
+// The unselected visible buttons, redrawn only when their GridSignature
+// changes
+RenderTexture2D gridTexture;
+bool gridTextureReady = false;
+unsigned long long gridTextureSignature = 0;
 
-ScriptGrid grids[MAX_GRIDS];
 int currentGridIndex = 0;
 int selectedScriptIndex = -1;
 bool isCFile = false;
@@ -60,253 +724,4619 @@ bool showHelpMenu = false;
 
 // Function definitions
 void SaveScriptToFile(const char* filename, const char* text) {
-    FILE* file = fopen(filename, "w");
+    FILE* file = ProfiledFopen(filename, "w");
     if (file) {
         fprintf(file, "%s", text);
         fclose(file);
+        // Don't wait for the watcher to report our own write
+        RefreshFileStatusForPath(filename);
+    }
+}
+
+// Read the whole file into a new buffer, NULL if it can't be opened
+char* LoadScriptFromFile(const char* filename, size_t* length) {
+    // A packed copy is used when there is no loose file or the loose file
+    // is the one that was packed; either way no open() or read()
+    int kind;
+    int scriptNumber = ParsePackFilename(filename, &kind);
+    const PackEntry* entry = scriptNumber > 0 ? FindPackEntry(scriptNumber, kind) : NULL;
+    struct stat buffer;
+    if (entry && (ProfiledStat(filename, &buffer) != 0 ||
+            ((int64_t)buffer.st_mtime == entry->mtime && (uint64_t)buffer.st_size == entry->length))) {
+        char* text = malloc(entry->length + 1);
+        if (text) {
+            memcpy(text, packData + entry->offset, entry->length);
+            text[entry->length] = '\0';
+        }
+        *length = text ? entry->length : 0;
+        return text;
+    }
+
+    FILE* file = ProfiledFopen(filename, "rb");
+    if (!file) {
+        // Fall back to the encoded copy, decoded straight into memory
+        char encoded[128];
+        snprintf(encoded, sizeof(encoded), "%s.txt", filename);
+        return DecodeScriptFile(encoded, length);
+    }
+
+    size_t capacity = 4096;
+    size_t used = 0;
+    char* text = malloc(capacity);
+    size_t got;
+    while (text && (got = fread(text + used, 1, capacity - used - 1, file)) > 0) {
+        used += got;
+        if (capacity - used - 1 == 0) {
+            capacity *= 2;
+            char* grown = realloc(text, capacity);
+            if (!grown) {
+                free(text);
+            }
+            text = grown;
+        }
+    }
+    fclose(file);
+    if (text) {
+        text[used] = '\0';
+    }
+    *length = text ? used : 0;
+    return text;
+}
+
+bool DoesFileExist(const char* filename) {
+    struct stat buffer;
+    return (ProfiledStat(filename, &buffer) == 0);
+}
+
+// Returns the script number for "scriptN.py" / "scriptN.c" (with or without
+// the gameFiles/ prefix), or 0 if the name is not a grid script
+int ParseScriptFilename(const char* filename, bool* isC) {
+    const char* name = strrchr(filename, '/');
+    name = name ? name + 1 : filename;
+    if (strncmp(name, "script", 6) != 0) {
+        return 0;
+    }
+
+    char* end;
+    long number = strtol(name + 6, &end, 10);
+    if (end == name + 6 || number < 1 || number > MAX_SCRIPT_NUMBER) {
+        return 0;
+    }
+    if (strcmp(end, ".c") == 0) {
+        *isC = true;
+    } else if (strcmp(end, ".py") == 0) {
+        *isC = false;
+    } else {
+        return 0;
+    }
+    return (int)number;
+}
+
+// Script number of an encoded "scriptN.py.txt" / "scriptN.c.txt", 0 if the
+// name is anything else
+int ParseEncodedFilename(const char* filename, bool* isC) {
+    size_t length = strlen(filename);
+    char base[64];
+    if (length < 5 || length - 4 >= sizeof(base) || strcmp(filename + length - 4, ".txt") != 0) {
+        return 0;
+    }
+    memcpy(base, filename, length - 4);
+    base[length - 4] = '\0';
+    return ParseScriptFilename(base, isC);
+}
+
+// Read the character map in 0.c's format: "index<tab>character" per
+// line, with Space, Tab and backslash escapes spelled out
+bool LoadCharMap(const char* path) {
+    FILE* file = ProfiledFopen(path, "r");
+    if (!file) {
+        return false;
+    }
+    memset(charMap, 0, sizeof(charMap));
+    charMapSize = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* tab = strchr(line, '\t');
+        int index = atoi(line);
+        if (!tab || index < 1 || index > MAX_CHAR_MAP) {
+            continue;
+        }
+        const char* part = tab + 1;
+        char c;
+        if (strcmp(part, "Space") == 0) {
+            c = ' ';
+        } else if (strcmp(part, "Tab") == 0) {
+            c = '\t';
+        } else if (part[0] == '\\' && part[1] != '\0' && part[2] == '\0') {
+            switch (part[1]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case 'r': c = '\r'; break;
+                case '0': c = '\0'; break;
+                case '\\': case '\'': case '"': c = part[1]; break;
+                default: continue;
+            }
+        } else if (part[0] != '\0') {
+            c = part[0];
+        } else {
+            continue;
+        }
+        charMap[index - 1] = c;
+        if (index > charMapSize) {
+            charMapSize = index;
+        }
+    }
+    fclose(file);
+    return charMapSize > 0;
+}
+
+// Decode an encoded script into a new buffer as it is read: digits build
+// up an index, anything else ends it. 0 and unknown indices become '?',
+// like 0.c's decoder. NULL without a map or a readable file.
+char* DecodeScriptFile(const char* path, size_t* length) {
+    *length = 0;
+    FILE* file = charMapSize > 0 ? ProfiledFopen(path, "rb") : NULL;
+    if (!file) {
+        return NULL;
+    }
+    size_t capacity = 4096;
+    size_t used = 0;
+    char* text = malloc(capacity);
+    char chunk[4096];
+    size_t got;
+    int index = -1;
+    while (text && (got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        for (size_t i = 0; i <= got && text; i++) {
+            char c = i < got ? chunk[i] : ' ';
+            if (c >= '0' && c <= '9') {
+                index = (index < 0 ? 0 : index * 10) + (c - '0');
+                if (index > MAX_CHAR_MAP) {
+                    index = MAX_CHAR_MAP + 1;  // stays out of range
+                }
+                continue;
+            }
+            if (i == got) {
+                break;  // an index may continue in the next chunk
+            }
+            if (index < 0) {
+                continue;
+            }
+            if (used + 1 == capacity) {
+                capacity *= 2;
+                char* grown = realloc(text, capacity);
+                if (!grown) {
+                    free(text);
+                }
+                text = grown;
+                if (!text) {
+                    break;
+                }
+            }
+            text[used++] = index >= 1 && index <= charMapSize ? charMap[index - 1] : '?';
+            index = -1;
+        }
+    }
+    fclose(file);
+    if (text && index >= 0 && used + 1 == capacity) {
+        char* grown = realloc(text, capacity + 1);  // room for the terminator
+        if (!grown) {
+            free(text);
+        }
+        text = grown;
+    }
+    if (text && index >= 0) {
+        text[used++] = index >= 1 && index <= charMapSize ? charMap[index - 1] : '?';
+    }
+    if (text) {
+        text[used] = '\0';
+    }
+    *length = text ? used : 0;
+    return text;
+}
+
+// A private copy of a script's decoded source for feeding to gcc or
+// python. The text cache is used while it is current, so running an
+// encoded script again decodes nothing; otherwise the copy is decoded and
+// also published to the cache. The caller frees it.
+char* CopyScriptSource(Script* script, const char* filename, size_t* length) {
+    char* copy = NULL;
+    pthread_mutex_lock(&scriptTextLock);
+    if (script->text && script->textMtime == script->status.mtime && strcmp(script->filename, filename) == 0) {
+        copy = malloc(script->textLength + 1);
+        if (copy) {
+            memcpy(copy, script->text, script->textLength + 1);
+            *length = script->textLength;
+        }
+        TouchScriptText(script);
+    }
+    pthread_mutex_unlock(&scriptTextLock);
+    if (copy) {
+        return copy;
+    }
+
+    char* text = LoadScriptFromFile(filename, length);
+    pthread_mutex_lock(&scriptTextLock);
+    bool current = strcmp(script->filename, filename) == 0;
+    pthread_mutex_unlock(&scriptTextLock);
+    if (text && current) {
+        copy = malloc(*length + 1);
+        if (copy) {
+            memcpy(copy, text, *length + 1);
+        }
+        SetScriptText(script, text, *length);
+        return copy;
+    }
+    return text;
+}
+
+// Slot and PACK_* kind of a script or description filename, 0 if it is
+// neither
+int ParsePackFilename(const char* filename, int* kind) {
+    const char* name = strrchr(filename, '/');
+    name = name ? name + 1 : filename;
+    char base[64];
+    snprintf(base, sizeof(base), "%s", name);
+    char* suffix = strstr(base, "_description.txt");
+    bool description = suffix && strcmp(suffix, "_description.txt") == 0;
+    if (description) {
+        *suffix = '\0';
+    }
+    bool isC = false;
+    int scriptNumber = ParseScriptFilename(base, &isC);
+    *kind = (isC ? PACK_C : PACK_PY) + (description ? PACK_PY_DESCRIPTION : 0);
+    return scriptNumber;
+}
+
+void PackFilename(int scriptNumber, int kind, char* filename, size_t size) {
+    snprintf(filename, size, GAME_FILES_PATH "script%d%s%s", scriptNumber,
+            (kind == PACK_C || kind == PACK_C_DESCRIPTION) ? ".c" : ".py",
+            kind >= PACK_PY_DESCRIPTION ? "_description.txt" : "");
+}
+
+// Map scripts.pack if there is one. On Windows it is read in one go.
+bool OpenScriptPack() {
+    FILE* file = ProfiledFopen(SCRIPT_PACK_PATH, "rb");
+    if (!file) {
+        return false;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    const unsigned char* data = NULL;
+#ifdef _WIN32
+    unsigned char* copy = size > 0 ? malloc(size) : NULL;
+    fseek(file, 0, SEEK_SET);
+    if (copy && fread(copy, 1, size, file) == (size_t)size) {
+        data = copy;
+    } else {
+        free(copy);
+    }
+#else
+    if (size > 0) {
+        void* mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        data = mapped == MAP_FAILED ? NULL : mapped;
+    }
+#endif
+    fclose(file);
+    if (!data) {
+        return false;
+    }
+
+    // Check the header and table before trusting any offset in them
+    const PackHeader* header = (const PackHeader*)data;
+    bool valid = (size_t)size >= sizeof(PackHeader) && memcmp(header->magic, "SPK1", 4) == 0 && header->version == 1 &&
+            header->tocOffset % 8 == 0 && header->tocOffset + 8 <= (uint64_t)size;
+    uint32_t count = valid ? *(const uint32_t*)(data + header->tocOffset) : 0;
+    valid = valid && header->tocOffset + 8 + (uint64_t)count * sizeof(PackEntry) <= (uint64_t)size;
+    const PackEntry* entries = valid ? (const PackEntry*)(data + header->tocOffset + 8) : NULL;
+    for (uint32_t i = 0; valid && i < count; i++) {
+        valid = entries[i].offset + entries[i].length <= header->tocOffset;
+    }
+    if (!valid) {
+        printf("%s is damaged and will be ignored.\n", SCRIPT_PACK_PATH);
+        return false;
+    }
+    packData = data;
+    packSize = size;
+    packEntries = entries;
+    packEntryCount = count;
+    return true;
+}
+
+const PackEntry* FindPackEntry(int scriptNumber, int kind) {
+    int low = 0;
+    int high = (int)packEntryCount - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        const PackEntry* entry = &packEntries[middle];
+        if (entry->scriptNumber == scriptNumber && entry->kind == kind) {
+            return entry;
+        }
+        if (entry->scriptNumber < scriptNumber || (entry->scriptNumber == scriptNumber && entry->kind < kind)) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return NULL;
+}
+
+// Write a packed file out as a loose one before something needs the real
+// file (gcc, python, the editor). Returns true if it was extracted.
+bool ExtractPackedFile(const char* filename) {
+    int kind;
+    int scriptNumber = ParsePackFilename(filename, &kind);
+    const PackEntry* entry = scriptNumber > 0 ? FindPackEntry(scriptNumber, kind) : NULL;
+    if (!entry || DoesFileExist(filename)) {
+        return false;
+    }
+    FILE* file = ProfiledFopen(filename, "wb");
+    if (!file) {
+        return false;
+    }
+    bool written = fwrite(packData + entry->offset, 1, entry->length, file) == entry->length;
+    if (fclose(file) != 0 || !written) {
+        return false;
+    }
+    // Keep the packed mtime so the pack still counts as current for it
+    struct utimbuf times = { (time_t)entry->mtime, (time_t)entry->mtime };
+    utime(filename, &times);
+    return true;
+}
+
+int ComparePackEntries(const void* a, const void* b) {
+    const PackEntry* x = (const PackEntry*)a;
+    const PackEntry* y = (const PackEntry*)b;
+    if (x->scriptNumber != y->scriptNumber) {
+        return x->scriptNumber < y->scriptNumber ? -1 : 1;
+    }
+    return x->kind - y->kind;
+}
+
+// Append a table of contents for entries at the end of file and point the
+// header at it. The header is only touched once everything before it is
+// written.
+bool FinishScriptPack(FILE* file, PackEntry* entries, uint32_t count) {
+    qsort(entries, count, sizeof(PackEntry), ComparePackEntries);
+    fseek(file, 0, SEEK_END);
+    long position = ftell(file);
+    while (position % 8 != 0) {
+        fputc(0, file);
+        position++;
+    }
+    uint32_t prefix[2] = { count, 0 };
+    bool ok = fwrite(prefix, sizeof(prefix), 1, file) == 1 &&
+            fwrite(entries, sizeof(PackEntry), count, file) == count && fflush(file) == 0;
+    PackHeader header = { { 'S', 'P', 'K', '1' }, 1, (uint64_t)position };
+    fseek(file, 0, SEEK_SET);
+    return ok && fwrite(&header, sizeof(header), 1, file) == 1 && fflush(file) == 0;
+}
+
+// Append one record and fill in its table entry
+bool AppendPackRecord(FILE* file, int scriptNumber, int kind, const char* data, uint32_t length, int64_t mtime, PackEntry* entry) {
+    fseek(file, 0, SEEK_END);
+    PackRecord record = { scriptNumber, kind, length, 0, mtime };
+    if (fwrite(&record, sizeof(record), 1, file) != 1) {
+        return false;
+    }
+    entry->scriptNumber = scriptNumber;
+    entry->kind = kind;
+    entry->length = length;
+    entry->reserved = 0;
+    entry->offset = (uint64_t)ftell(file);
+    entry->mtime = mtime;
+    return fwrite(data, 1, length, file) == length;
+}
+
+// --pack: append every loose script and description that is new or changed
+// since it was last packed, then a new table of contents
+int PackGameFiles() {
+    if (!OpenScriptPack() && DoesFileExist(SCRIPT_PACK_PATH)) {
+        return 1;
+    }
+    FILE* file = ProfiledFopen(SCRIPT_PACK_PATH, packData ? "r+b" : "w+b");
+    if (!file) {
+        printf("Could not open %s.\n", SCRIPT_PACK_PATH);
+        return 1;
+    }
+    if (!packData) {
+        PackHeader header = { { 'S', 'P', 'K', '1' }, 1, 0 };
+        fwrite(&header, sizeof(header), 1, file);
+    }
+
+    uint32_t capacity = packEntryCount + 1024;
+    uint32_t count = packEntryCount;
+    PackEntry* entries = malloc(capacity * sizeof(PackEntry));
+    memcpy(entries, packEntries, packEntryCount * sizeof(PackEntry));
+
+    int added = 0;
+    int unchanged = 0;
+    bool ok = true;
+    DIR* dir = opendir(GAME_FILES_PATH);
+    struct dirent* item;
+    while (ok && dir && (item = readdir(dir)) != NULL) {
+        int kind;
+        int scriptNumber = ParsePackFilename(item->d_name, &kind);
+        char filename[128];
+        struct stat buffer;
+        PackFilename(scriptNumber, kind, filename, sizeof(filename));
+        if (scriptNumber == 0 || ProfiledStat(filename, &buffer) != 0) {
+            continue;
+        }
+        const PackEntry* old = FindPackEntry(scriptNumber, kind);
+        if (old && old->mtime == (int64_t)buffer.st_mtime && old->length == (uint64_t)buffer.st_size) {
+            unchanged++;
+            continue;
+        }
+
+        size_t length;
+        char* text = LoadScriptFromFile(filename, &length);
+        if (!text) {
+            continue;
+        }
+        PackEntry entry;
+        ok = AppendPackRecord(file, scriptNumber, kind, text, (uint32_t)length, (int64_t)buffer.st_mtime, &entry);
+        free(text);
+        if (old) {
+            entries[old - packEntries] = entry;  // same sorted position as before
+        } else {
+            if (count == capacity) {
+                capacity *= 2;
+                entries = realloc(entries, capacity * sizeof(PackEntry));
+            }
+            entries[count++] = entry;
+        }
+        added++;
+    }
+    if (dir) {
+        closedir(dir);
+    }
+
+    ok = ok && FinishScriptPack(file, entries, count);
+    ok = fclose(file) == 0 && ok;
+    free(entries);
+    if (!ok) {
+        printf("Could not write %s.\n", SCRIPT_PACK_PATH);
+        return 1;
+    }
+    printf("Packed %d files, %d unchanged, %u in %s.\n", added, unchanged, count, SCRIPT_PACK_PATH);
+    return 0;
+}
+
+// --unpack: write packed files back out as loose files, leaving loose
+// files that are newer than their packed copy alone
+int UnpackGameFiles() {
+    if (!OpenScriptPack()) {
+        printf("There is no %s to unpack.\n", SCRIPT_PACK_PATH);
+        return 1;
+    }
+    int written = 0;
+    for (uint32_t i = 0; i < packEntryCount; i++) {
+        const PackEntry* entry = &packEntries[i];
+        char filename[128];
+        struct stat buffer;
+        PackFilename(entry->scriptNumber, entry->kind, filename, sizeof(filename));
+        if (ProfiledStat(filename, &buffer) == 0 && (int64_t)buffer.st_mtime >= entry->mtime) {
+            continue;
+        }
+        remove(filename);
+        written += ExtractPackedFile(filename);
+    }
+    printf("Unpacked %d of %u files.\n", written, packEntryCount);
+    return 0;
+}
+
+// --compact-pack: rewrite the store with only the current version of each
+// file, in slot order, and replace the old one
+int CompactScriptPack() {
+    if (!OpenScriptPack()) {
+        printf("There is no %s to compact.\n", SCRIPT_PACK_PATH);
+        return 1;
+    }
+    FILE* file = ProfiledFopen(SCRIPT_PACK_PATH ".tmp", "w+b");
+    if (!file) {
+        printf("Could not write %s.tmp.\n", SCRIPT_PACK_PATH);
+        return 1;
+    }
+    PackHeader header = { { 'S', 'P', 'K', '1' }, 1, 0 };
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    PackEntry* entries = malloc((packEntryCount + 1) * sizeof(PackEntry));
+    for (uint32_t i = 0; ok && i < packEntryCount; i++) {
+        const PackEntry* old = &packEntries[i];
+        ok = AppendPackRecord(file, old->scriptNumber, old->kind, (const char*)packData + old->offset,
+                old->length, old->mtime, &entries[i]);
+    }
+    ok = ok && FinishScriptPack(file, entries, packEntryCount);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    ok = fclose(file) == 0 && ok;
+    free(entries);
+
+#ifdef _WIN32
+    // rename() will not replace an existing file on Windows
+    if (ok) {
+        remove(SCRIPT_PACK_PATH);
+    }
+#endif
+    if (!ok || rename(SCRIPT_PACK_PATH ".tmp", SCRIPT_PACK_PATH) != 0) {
+        remove(SCRIPT_PACK_PATH ".tmp");
+        printf("Could not compact %s.\n", SCRIPT_PACK_PATH);
+        return 1;
+    }
+    printf("Compacted %s from %zu to %ld bytes.\n", SCRIPT_PACK_PATH, packSize, size);
+    return 0;
+}
+
+void RefreshFileStatus(int scriptNumber) {
+    char filename[100];
+    struct stat buffer;
+    Script* script = GetScript(scriptNumber);
+    FileStatus* status = &script->status;
+
+    status->flags = 0;
+    status->mtime = 0;
+    snprintf(filename, sizeof(filename), GAME_FILES_PATH "script%d.py", scriptNumber);
+    if (ProfiledStat(filename, &buffer) == 0 || (strcat(filename, ".txt") && ProfiledStat(filename, &buffer) == 0)) {
+        status->flags |= STATUS_PY;
+        status->mtime = buffer.st_mtime;
+    }
+    snprintf(filename, sizeof(filename), GAME_FILES_PATH "script%d.c", scriptNumber);
+    if (ProfiledStat(filename, &buffer) == 0 || (strcat(filename, ".txt") && ProfiledStat(filename, &buffer) == 0)) {
+        status->flags |= STATUS_C;
+        if (buffer.st_mtime > status->mtime) {
+            status->mtime = buffer.st_mtime;
+        }
+    }
+    status->flags |= FindPackEntry(scriptNumber, PACK_PY) ? STATUS_PY : 0;
+    status->flags |= FindPackEntry(scriptNumber, PACK_C) ? STATUS_C : 0;
+
+    QueueIndexUpdate(scriptNumber);
+
+    // Follow a file that appeared in the other language unless the slot is in use
+    if (!ScriptFileExists(script) && status->flags && !script->isEditing) {
+        ChooseScriptFile(script);
+    }
+    if (status->flags && (scriptNumber - 1) / scriptsPerGrid + 2 > gridCount) {
+        gridCount = (scriptNumber - 1) / scriptsPerGrid + 2;
+    }
+}
+
+void RefreshFileStatusForPath(const char* filename) {
+    bool isC;
+    int scriptNumber = ParseScriptFilename(filename, &isC);
+    if (scriptNumber == 0) {
+        scriptNumber = ParseEncodedFilename(filename, &isC);
+    }
+    if (scriptNumber > 0) {
+        RefreshFileStatus(scriptNumber);
+    }
+}
+
+// Look up a script, NULL if its slot was never created
+Script* FindScript(int scriptNumber) {
+    Script* found = NULL;
+    pthread_mutex_lock(&slotLock);
+    if (slotCapacity > 0) {
+        unsigned int mask = (unsigned int)slotCapacity - 1;
+        for (unsigned int i = ((unsigned int)scriptNumber * 2654435761u) & mask; slotTable[i]; i = (i + 1) & mask) {
+            if (slotTable[i]->number == scriptNumber) {
+                found = slotTable[i];
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&slotLock);
+    return found;
+}
+
+// Look up a script, creating its slot on first use
+Script* GetScript(int scriptNumber) {
+    Script* script = FindScript(scriptNumber);
+    if (script) {
+        return script;
+    }
+
+    pthread_mutex_lock(&slotLock);
+    if ((slotCount + 1) * 4 > slotCapacity * 3) {
+        // Keep the table under 75% full
+        int capacity = slotCapacity ? slotCapacity * 2 : INITIAL_SLOT_CAPACITY;
+        Script** table = calloc(capacity, sizeof(Script*));
+        for (int i = 0; i < slotCapacity; i++) {
+            if (slotTable[i]) {
+                unsigned int j = ((unsigned int)slotTable[i]->number * 2654435761u) & (capacity - 1);
+                while (table[j]) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                table[j] = slotTable[i];
+            }
+        }
+        free(slotTable);
+        slotTable = table;
+        slotCapacity = capacity;
+    }
+
+    unsigned int mask = (unsigned int)slotCapacity - 1;
+    unsigned int i = ((unsigned int)scriptNumber * 2654435761u) & mask;
+    while (slotTable[i] && slotTable[i]->number != scriptNumber) {
+        i = (i + 1) & mask;
+    }
+    if (!slotTable[i]) {
+        // Another thread may have created it between the lookups above
+        script = calloc(1, sizeof(Script));
+        script->number = scriptNumber;
+        script->compileState = COMPILE_IDLE;
+        ChooseScriptFile(script);
+        slotTable[i] = script;
+        slotCount++;
+    }
+    script = slotTable[i];
+    pthread_mutex_unlock(&slotLock);
+    return script;
+}
+
+Script* GetGridScript(int gridIndex, int index) {
+    return GetScript(gridIndex * scriptsPerGrid + index + 1);
+}
+
+// Prefer an existing Python script, then an existing C script, otherwise
+// default to the current mode
+void ChooseScriptFile(Script* script) {
+    bool useC = isCFile;
+    if (script->status.flags & STATUS_PY) {
+        useC = false;
+    } else if (script->status.flags & STATUS_C) {
+        useC = true;
+    }
+    pthread_mutex_lock(&scriptTextLock);
+    script->isCFile = useC;
+    snprintf(script->filename, sizeof(script->filename),
+            script->isCFile ? GAME_FILES_PATH "script%d.c" : GAME_FILES_PATH "script%d.py", script->number);
+    pthread_mutex_unlock(&scriptTextLock);
+}
+
+bool ScriptFileExists(const Script* script) {
+    return (script->status.flags & (script->isCFile ? STATUS_C : STATUS_PY)) != 0;
+}
+
+// Move a script to the front of the text cache. Called with scriptTextLock held.
+void TouchScriptText(Script* script) {
+    if (lruHead == script) {
+        return;
+    }
+    if (script->lruPrev) {
+        script->lruPrev->lruNext = script->lruNext;
+    }
+    if (script->lruNext) {
+        script->lruNext->lruPrev = script->lruPrev;
+    }
+    if (lruTail == script) {
+        lruTail = script->lruPrev;
+    }
+    script->lruPrev = NULL;
+    script->lruNext = lruHead;
+    if (lruHead) {
+        lruHead->lruPrev = script;
+    }
+    lruHead = script;
+    if (!lruTail) {
+        lruTail = script;
+    }
+}
+
+// Read the script from disk without holding the lock, then publish it and
+// evict the least recently used texts while the cache is over budget
+void LoadScriptText(Script* script) {
+    char filename[sizeof(script->filename)];
+    pthread_mutex_lock(&scriptTextLock);
+    memcpy(filename, script->filename, sizeof(filename));
+    pthread_mutex_unlock(&scriptTextLock);
+    size_t length;
+    char* text = LoadScriptFromFile(filename, &length);
+    SetScriptText(script, text, length);
+}
+
+// Publish new text for a script; the cache takes ownership of text
+void SetScriptText(Script* script, char* text, size_t length) {
+    pthread_mutex_lock(&scriptTextLock);
+    if (script->text) {
+        textCacheBytes -= script->textLength;
+        free(script->text);
+    }
+    script->text = text;
+    script->textLength = length;
+    script->textLoaded = true;
+    script->textMtime = script->status.mtime;
+    textCacheBytes += length;
+    TouchScriptText(script);
+
+    while (textCacheBytes > TEXT_CACHE_BYTES && lruTail && lruTail != script) {
+        Script* oldest = lruTail;
+        lruTail = oldest->lruPrev;
+        lruTail->lruNext = NULL;
+        oldest->lruPrev = NULL;
+        textCacheBytes -= oldest->textLength;
+        free(oldest->text);
+        oldest->text = NULL;
+        oldest->textLength = 0;
+        oldest->textLoaded = false;
+    }
+    pthread_mutex_unlock(&scriptTextLock);
+}
+
+void StartFileWatcher() {
+#ifdef __linux__
+    watchFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchFd >= 0 && inotify_add_watch(watchFd, GAME_FILES_PATH,
+            IN_CREATE | IN_DELETE | IN_CLOSE_WRITE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB) < 0) {
+        close(watchFd);
+        watchFd = -1;
+    }
+    if (watchFd < 0) {
+        printf("File watcher unavailable, polling gameFiles/ instead.\n");
+    }
+#endif
+}
+
+// Apply pending changes in gameFiles/ to the status table. Called once per
+// frame; with inotify this is a single non-blocking read. Returns true if
+// anything may have changed.
+bool PollFileWatcher() {
+    bool changed = false;
+#ifdef __linux__
+    if (watchFd >= 0) {
+        char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        ssize_t length;
+        while ((length = read(watchFd, events, sizeof(events))) > 0) {
+            changed = true;
+            for (char* p = events; p < events + length; ) {
+                struct inotify_event* event = (struct inotify_event*)p;
+                if (event->mask & IN_Q_OVERFLOW) {
+                    // Events were dropped, fall back to a full rescan
+                    RescanGameFiles();
+                } else if (event->len > 0) {
+                    RefreshFileStatusForPath(event->name);
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+    // No watcher: rescan the directory once a second. One readdir() costs
+    // the same however many cells are on screen.
+    if (++statusPollFrame >= STATUS_POLL_FRAMES) {
+        statusPollFrame = 0;
+        changed = RescanGameFiles();
+    }
+    return changed;
+}
+
+// Rebuild every slot's file flags from a fresh directory scan
+bool RescanGameFiles() {
+    pthread_mutex_lock(&slotLock);
+    for (int i = 0; i < slotCapacity; i++) {
+        if (slotTable[i]) {
+            slotTable[i]->status.flags = 0;
+        }
+    }
+    pthread_mutex_unlock(&slotLock);
+    ScanGameFiles();
+
+    // Follow files that moved to the other language, as RefreshFileStatus
+    // does, and take a snapshot of the slots: the table may grow once the
+    // lock is released
+    pthread_mutex_lock(&slotLock);
+    Script** scripts = malloc((slotCount + 1) * sizeof(Script*));
+    int count = 0;
+    for (int i = 0; i < slotCapacity && scripts; i++) {
+        Script* script = slotTable[i];
+        if (!script) {
+            continue;
+        }
+        if (!ScriptFileExists(script) && script->status.flags && !script->isEditing) {
+            ChooseScriptFile(script);
+        }
+        scripts[count++] = script;
+    }
+    pthread_mutex_unlock(&slotLock);
+
+    // Re-index only slots whose files came or went since they were last
+    // indexed; this runs every few seconds without a watcher
+    int changed = 0;
+    pthread_mutex_lock(&indexQueueLock);
+    for (int i = 0; i < count; i++) {
+        if (scripts[i]->status.flags != scripts[i]->indexFlags) {
+            scripts[changed++] = scripts[i];
+        }
+    }
+    pthread_mutex_unlock(&indexQueueLock);
+    for (int i = 0; i < changed; i++) {
+        QueueIndexUpdate(scripts[i]->number);
+    }
+    free(scripts);
+    return true;
+}
+
+#ifndef _WIN32
+// pipe() with both ends close-on-exec from the start. Setting the flag
+// afterwards leaves a window in which a child spawned by another thread
+// inherits the ends and holds the pipe open.
+int OpenPipe(int fds[2]) {
+#ifdef __linux__
+    return pipe2(fds, O_CLOEXEC);
+#else
+    if (pipe(fds) != 0) {
+        return -1;
+    }
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return 0;
+#endif
+}
+#endif
+
+// Tell an idle frame loop to draw again. Safe from any thread.
+void WakeFrameLoop() {
+    atomic_store(&uiChanged, true);
+#ifndef _WIN32
+    if (uiWakePipe[1] >= 0) {
+        char wake = 1;
+        ssize_t ignored = write(uiWakePipe[1], &wake, 1);
+        (void)ignored;
+    }
+#endif
+}
+
+// Sleep until a worker wakes us, gameFiles/ changes or the timeout passes.
+// Window input has no descriptor we can wait on, so the timeout also
+// bounds how long a key press or mouse move goes unnoticed.
+void WaitForActivity(int timeoutMs) {
+#ifndef _WIN32
+    if (uiWakePipe[0] < 0 && OpenPipe(uiWakePipe) == 0) {
+        for (int i = 0; i < 2; i++) {
+            fcntl(uiWakePipe[i], F_SETFL, O_NONBLOCK);
+        }
+    }
+    struct pollfd fds[2];
+    int count = 0;
+    if (uiWakePipe[0] >= 0) {
+        fds[count].fd = uiWakePipe[0];
+        fds[count++].events = POLLIN;
+    }
+    if (watchFd >= 0) {
+        fds[count].fd = watchFd;
+        fds[count++].events = POLLIN;
+    }
+    if (!atomic_load(&uiChanged)) {
+        poll(fds, count, timeoutMs);
+    }
+    char drain[64];
+    while (uiWakePipe[0] >= 0 && read(uiWakePipe[0], drain, sizeof(drain)) > 0) {
+    }
+#else
+    if (!atomic_load(&uiChanged)) {
+        WaitTime(timeoutMs / 1000.0);
+    }
+#endif
+}
+
+// Anything the user did since the last input poll
+bool InputActivity() {
+    Vector2 delta = GetMouseDelta();
+    if (delta.x != 0 || delta.y != 0 || GetMouseWheelMove() != 0 || IsWindowResized()) {
+        return true;
+    }
+    for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++) {
+        if (IsMouseButtonDown(button) || IsMouseButtonReleased(button)) {
+            return true;
+        }
+    }
+    for (int key = KEY_SPACE; key <= KEY_KP_EQUAL; key++) {
+        if (IsKeyDown(key) || IsKeyReleased(key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Queue a program for launch without a shell. Returns a handle for
+// GetProcessState, or 0 if too many jobs are still outstanding.
+// Fill the next free slot in the job table. Called with processLock held.
+ProcessJob* ClaimProcessJob(const char* const* argv, int scriptNumber, OutputRing* output) {
+    ProcessJob* job = &processJobs[nextProcessHandle % MAX_PROCESS_JOBS];
+    if (job->state == PROCESS_QUEUED || job->state == PROCESS_RUNNING) {
+        printf("Too many scripts waiting to run, try again later.\n");
+        return NULL;
+    }
+
+    for (int i = 0; i <= MAX_PROCESS_ARGS; i++) {
+        free(job->argv[i]);
+        job->argv[i] = NULL;
+    }
+    for (int i = 0; i < MAX_PROCESS_ARGS && argv[i]; i++) {
+        job->argv[i] = strdup(argv[i]);
+    }
+    job->handle = nextProcessHandle++;
+    job->state = PROCESS_QUEUED;
+    job->scriptNumber = scriptNumber;
+    job->exitCode = 0;
+    job->output = output;
+    job->warm = false;
+    job->startedAt = 0;
+    job->finishedAt = 0;
+    memset(&job->record, 0, sizeof(job->record));
+    job->pipelined = false;
+    job->stdinFd = -1;
+    job->stdoutFd = -1;
+    return job;
+}
+
+int SubmitProcess(const char* const* argv, int scriptNumber, OutputRing* output) {
+    pthread_mutex_lock(&processLock);
+    ProcessJob* job = ClaimProcessJob(argv, scriptNumber, output);
+    int handle = job ? job->handle : 0;
+    if (job) {
+        pthread_cond_broadcast(&processReady);
+    }
+    pthread_mutex_unlock(&processLock);
+#ifndef _WIN32
+    // Wake the reaper so it can start the job right away
+    char wake = 1;
+    ssize_t ignored = write(processWakePipe[1], &wake, 1);
+    (void)ignored;
+#endif
+    return handle;
+}
+
+// Queue a Python script for the warm workers. Same handles and states as
+// SubmitProcess, so the grid shows its status the same way.
+int SubmitWarmPython(const char* filename, int scriptNumber, OutputRing* output) {
+    const char* argv[] = { filename, NULL };
+    pthread_mutex_lock(&processLock);
+    ProcessJob* job = ClaimProcessJob(argv, scriptNumber, output);
+    int handle = 0;
+    if (job) {
+        job->warm = true;
+        handle = job->handle;
+        pthread_cond_signal(&pythonWorkReady);
+    }
+    pthread_mutex_unlock(&processLock);
+    return handle;
+}
+
+// Like GetProcessState, also copying the run's record once it is done
+int GetProcessRecord(int handle, RunRecord* record) {
+    int state = PROCESS_FREE;
+    pthread_mutex_lock(&processLock);
+    ProcessJob* job = &processJobs[handle % MAX_PROCESS_JOBS];
+    if (handle > 0 && job->handle == handle) {
+        state = job->state;
+        *record = job->record;
+    }
+    pthread_mutex_unlock(&processLock);
+    return state;
+}
+
+// When a job started and finished running, 0 while it has not
+int GetProcessTimes(int handle, double* startedAt, double* finishedAt) {
+    int state = PROCESS_FREE;
+    pthread_mutex_lock(&processLock);
+    ProcessJob* job = &processJobs[handle % MAX_PROCESS_JOBS];
+    if (handle > 0 && job->handle == handle) {
+        state = job->state;
+        *startedAt = job->startedAt;
+        *finishedAt = job->finishedAt;
+    }
+    pthread_mutex_unlock(&processLock);
+    return state;
+}
+
+// Fill in the job's record and log it. Called with processLock held.
+void RecordRun(ProcessJob* job) {
+    job->finishedAt = NowSeconds();
+    job->record.scriptNumber = job->scriptNumber;
+    job->record.exitCode = job->exitCode;
+    job->record.finishedAt = (int64_t)time(NULL);
+    job->record.wallSeconds = (float)(job->finishedAt - job->startedAt);
+    if (job->warm) {
+        job->record.flags |= RUN_WARM;
+    }
+    ProfileSpan(job->scriptNumber, false, job->startedAt, job->finishedAt);
+
+    pthread_mutex_lock(&historyLock);
+    if (historyFile) {
+        fwrite(&job->record, sizeof(RunRecord), 1, historyFile);
+        fflush(historyFile);
+    }
+    pthread_mutex_unlock(&historyLock);
+    AddRunHistory(&job->record);
+}
+
+void AddRunHistory(const RunRecord* record) {
+    Script* script = FindScript(record->scriptNumber);
+    if (!script) {
+        return;
+    }
+    pthread_mutex_lock(&historyLock);
+    if (script->recentRunCount == RUN_HISTORY_LENGTH) {
+        memmove(script->recentRuns, script->recentRuns + 1, (RUN_HISTORY_LENGTH - 1) * sizeof(float));
+        script->recentRunCount--;
+    }
+    script->recentRuns[script->recentRunCount++] = record->wallSeconds;
+    pthread_mutex_unlock(&historyLock);
+    atomic_fetch_add(&runHistoryVersion, 1);
+}
+
+// Replay the log into the scripts' recent runs and open it for appending.
+// A log past RUN_HISTORY_MAX_BYTES is rewritten with its newest half.
+void LoadRunHistory() {
+    FILE* file = ProfiledFopen(RUN_HISTORY_PATH, "rb");
+    if (file) {
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        size_t count = size > 0 ? (size_t)size / sizeof(RunRecord) : 0;
+        RunRecord* records = malloc((count > 0 ? count : 1) * sizeof(RunRecord));
+        count = fread(records, sizeof(RunRecord), count, file);
+        fclose(file);
+
+        size_t first = 0;
+        if (size > RUN_HISTORY_MAX_BYTES) {
+            first = count / 2;
+            FILE* trimmed = ProfiledFopen(RUN_HISTORY_PATH ".tmp", "wb");
+            if (trimmed) {
+                bool written = fwrite(records + first, sizeof(RunRecord), count - first, trimmed) == count - first;
+                if (fclose(trimmed) == 0 && written) {
+                    remove(RUN_HISTORY_PATH);
+                    rename(RUN_HISTORY_PATH ".tmp", RUN_HISTORY_PATH);
+                }
+            }
+        }
+        for (size_t i = first; i < count; i++) {
+            AddRunHistory(&records[i]);
+        }
+        free(records);
+    }
+    historyFile = ProfiledFopen(RUN_HISTORY_PATH, "ab");
+}
+
+// Green for quick runs through yellow to red at SLOW_RUN_SECONDS
+Color HeatColor(float seconds) {
+    float t = seconds / SLOW_RUN_SECONDS;
+    if (t > 1) {
+        t = 1;
+    }
+    if (t < 0.5f) {
+        return (Color){ (unsigned char)(510 * t), 200, 0, 255 };
+    }
+    return (Color){ 255, (unsigned char)(200 * (2 - 2 * t)), 0, 255 };
+}
+
+// PROCESS_QUEUED / RUNNING / DONE, or PROCESS_FREE for an unknown or
+// expired handle
+int GetProcessState(int handle, int* exitCode) {
+    int state = PROCESS_FREE;
+    pthread_mutex_lock(&processLock);
+    ProcessJob* job = &processJobs[handle % MAX_PROCESS_JOBS];
+    if (handle > 0 && job->handle == handle) {
+        state = job->state;
+        if (exitCode) {
+            *exitCode = job->exitCode;
+        }
+    }
+    pthread_mutex_unlock(&processLock);
+    return state;
+}
+
+#ifndef _WIN32
+// Start queued jobs in order while there is room. Pipeline stages start
+// regardless of -j: a stage left waiting for a slot would stall the stages
+// writing to it. Called with processLock held.
+void StartQueuedProcesses() {
+    while (nextStartHandle < nextProcessHandle) {
+        ProcessJob* job = &processJobs[nextStartHandle % MAX_PROCESS_JOBS];
+        if (job->state == PROCESS_QUEUED && !job->warm && !job->pipelined && runningProcesses >= maxRunningProcesses) {
+            break;
+        }
+        nextStartHandle++;
+        if (job->state != PROCESS_QUEUED || job->warm) {
+            continue;
+        }
+
+        // Captured jobs get their own non-blocking stdout and stderr pipes;
+        // a pipeline stage's stdout goes to the next stage instead
+        int outPipe[2] = { -1, -1 };
+        int errPipe[2] = { -1, -1 };
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        if (job->output && (job->stdoutFd >= 0 || OpenPipe(outPipe) == 0) && OpenPipe(errPipe) != 0) {
+            // run uncaptured rather than leak the stdout pipe
+            for (int i = 0; i < 2; i++) {
+                if (outPipe[i] >= 0) {
+                    close(outPipe[i]);
+                    outPipe[i] = -1;
+                }
+            }
+        }
+        if (errPipe[0] >= 0) {
+            if (outPipe[1] >= 0) {
+                posix_spawn_file_actions_adddup2(&actions, outPipe[1], 1);
+            }
+            posix_spawn_file_actions_adddup2(&actions, errPipe[1], 2);
+        }
+        if (job->stdinFd >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, job->stdinFd, 0);
+        }
+        if (job->stdoutFd >= 0) {
+            posix_spawn_file_actions_adddup2(&actions, job->stdoutFd, 1);
+        }
+
+        extern char** environ;
+        char* limitedArgv[MAX_PROCESS_ARGS + 5];
+        char limitScript[160];
+        char** spawnArgv = LimitedArgv(job, limitedArgv, limitScript, sizeof(limitScript));
+        int result = posix_spawnp(&job->pid, spawnArgv[0], &actions, NULL, spawnArgv, environ);
+        atomic_fetch_add(&spawnCalls, 1);
+        posix_spawn_file_actions_destroy(&actions);
+
+        // The child has its own copies of the pipeline ends now
+        if (job->stdinFd >= 0) {
+            close(job->stdinFd);
+            job->stdinFd = -1;
+        }
+        if (job->stdoutFd >= 0) {
+            close(job->stdoutFd);
+            job->stdoutFd = -1;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (outPipe[1 - i] >= 0 && (i == 0 || result != 0)) {
+                close(outPipe[1 - i]);
+            }
+            if (errPipe[1 - i] >= 0 && (i == 0 || result != 0)) {
+                close(errPipe[1 - i]);
+            }
+        }
+
+        if (result != 0) {
+            printf("Could not start %s.\n", job->argv[0]);
+            job->state = PROCESS_DONE;
+            job->exitCode = 127;
+            WakeFrameLoop();
+            if (job->output) {
+                const char* message = "Could not start the script.\n";
+                OutputRingWrite(job->output, STREAM_STDERR, message, strlen(message));
+                atomic_store(&job->output->closed, true);
+            }
+            continue;
+        }
+        if (job->output) {
+            if (errPipe[0] >= 0) {
+                RegisterOutputStreams(outPipe[0], errPipe[0], job->output);
+            } else {
+                // Pipes could not be created, the script wrote to the terminal
+                atomic_store(&job->output->closed, true);
+            }
+        }
+        job->pidfd = -1;
+#if defined(__linux__) && defined(SYS_pidfd_open)
+        job->pidfd = (int)syscall(SYS_pidfd_open, job->pid, 0);
+#endif
+        job->startedAt = NowSeconds();
+        job->state = PROCESS_RUNNING;
+        runningProcesses++;
+        WakeFrameLoop();
+    }
+}
+
+// The argv to spawn for a job. With -c or -m set, the script is started
+// through "sh -c 'ulimit ...; exec \"$@\"'", so the limits are in place
+// before its first instruction; posix_spawn cannot call setrlimit in the
+// child itself. The shell execs the script, so the pid, the exit status
+// and the rusage are still the script's own.
+char** LimitedArgv(ProcessJob* job, char** argv, char* script, size_t size) {
+#ifdef __linux__
+    if (cpuLimitSeconds <= 0 && memoryLimitMb <= 0) {
+        return job->argv;
+    }
+    int length = 0;
+    script[0] = '\0';
+    if (cpuLimitSeconds > 0) {
+        // SIGXCPU at the limit, SIGKILL a second later
+        length += snprintf(script + length, size - length, "ulimit -S -t %d && ulimit -H -t %d && ",
+                cpuLimitSeconds, cpuLimitSeconds + 1);
+    }
+    if (memoryLimitMb > 0) {
+        snprintf(script + length, size - length, "ulimit -v %lld && ", (long long)memoryLimitMb * 1024);
+    }
+    strncat(script, "exec \"$@\"", size - strlen(script) - 1);
+
+    int count = 0;
+    argv[count++] = "sh";
+    argv[count++] = "-c";
+    argv[count++] = script;
+    argv[count++] = "sh";
+    for (int i = 0; i < MAX_PROCESS_ARGS && job->argv[i]; i++) {
+        argv[count++] = job->argv[i];
+    }
+    argv[count] = NULL;
+    return argv;
+#else
+    (void)argv;
+    (void)script;
+    (void)size;
+    return job->argv;
+#endif
+}
+
+// Reap a finished job and record what it used. Called with processLock held.
+bool ReapProcess(ProcessJob* job) {
+    int status = 0;
+    struct rusage usage;
+    memset(&usage, 0, sizeof(usage));
+    if (wait4(job->pid, &status, WNOHANG, &usage) != job->pid) {
+        return false;
+    }
+    if (job->pidfd >= 0) {
+        close(job->pidfd);
+        job->pidfd = -1;
+    }
+    job->exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+    job->record.cpuSeconds = (float)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+            (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6);
+#ifdef __APPLE__
+    job->record.maxRssKb = (int32_t)(usage.ru_maxrss / 1024);  // bytes there
+#else
+    job->record.maxRssKb = (int32_t)usage.ru_maxrss;
+#endif
+    RecordRun(job);
+    job->state = PROCESS_DONE;
+    runningProcesses--;
+    WakeFrameLoop();
+    return true;
+}
+
+// Launches queued jobs and waits on the running ones' pidfds (plus the
+// wake pipe for new submissions), so finished scripts are reaped and the
+// next ones started without involving the frame loop
+void* ProcessReaperThread(void* arg) {
+    (void)arg;
+    struct pollfd fds[MAX_PROCESS_LIMIT + 1];
+    while (1) {
+        int count = 0;
+        int timeout = -1;  // a running job without a pidfd or with a deadline shortens this
+
+        pthread_mutex_lock(&processLock);
+        StartQueuedProcesses();
+        fds[count].fd = processWakePipe[0];
+        fds[count++].events = POLLIN;
+        double now = NowSeconds();
+        for (int i = 0; i < MAX_PROCESS_JOBS; i++) {
+            ProcessJob* job = &processJobs[i];
+            if (job->state != PROCESS_RUNNING || job->warm) {
+                continue;
+            }
+            if (job->pidfd >= 0 && count <= MAX_PROCESS_LIMIT) {
+                fds[count].fd = job->pidfd;
+                fds[count++].events = POLLIN;
+            } else {
+                timeout = 50;
+            }
+
+            // Kill scripts that overran the -t timeout; the reap below records it
+            if (runTimeout > 0 && !(job->record.flags & RUN_TIMED_OUT)) {
+                double remaining = job->startedAt + runTimeout - now;
+                if (remaining <= 0) {
+                    kill(job->pid, SIGKILL);
+                    job->record.flags |= RUN_TIMED_OUT;
+                } else if (timeout < 0 || remaining * 1000 < timeout) {
+                    timeout = (int)(remaining * 1000) + 1;
+                }
+            }
+        }
+        pthread_mutex_unlock(&processLock);
+
+        poll(fds, count, timeout);
+
+        char drain[64];
+        if (fds[0].revents & POLLIN) {
+            ssize_t ignored = read(processWakePipe[0], drain, sizeof(drain));
+            (void)ignored;
+        }
+
+        pthread_mutex_lock(&processLock);
+        for (int i = 0; i < MAX_PROCESS_JOBS; i++) {
+            if (processJobs[i].state == PROCESS_RUNNING && !processJobs[i].warm) {
+                ReapProcess(&processJobs[i]);
+            }
+        }
+        pthread_mutex_unlock(&processLock);
+    }
+    return NULL;
+}
+
+// Append one framed chunk if it fits. Producer side only.
+bool OutputRingWrite(OutputRing* ring, int stream, const char* data, size_t length) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (OUTPUT_RING_SIZE - (head - tail) < length + 3) {
+        return false;
+    }
+
+    unsigned char header[3] = { (unsigned char)stream, (unsigned char)(length & 0xFF), (unsigned char)(length >> 8) };
+    for (int i = 0; i < 3; i++) {
+        ring->data[(head + i) & (OUTPUT_RING_SIZE - 1)] = (char)header[i];
+    }
+    for (size_t i = 0; i < length; i++) {
+        ring->data[(head + 3 + i) & (OUTPUT_RING_SIZE - 1)] = data[i];
+    }
+    atomic_store_explicit(&ring->head, head + 3 + length, memory_order_release);
+    return true;
+}
+
+// Payload bytes a single chunk could carry right now. Producer side only.
+size_t OutputRingSpace(OutputRing* ring) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t space = OUTPUT_RING_SIZE - (head - tail);
+    return space > 3 ? space - 3 : 0;
+}
+
+// Hand a job's pipes (outFd is -1 when stdout goes elsewhere) to the
+// reader thread. Streams stay in its table until EOF, which a background
+// grandchild holding a pipe can put off indefinitely; with the table full
+// the pipes are closed instead and the script's writes to them fail.
+void RegisterOutputStreams(int outFd, int errFd, OutputRing* ring) {
+    int count = outFd >= 0 ? 2 : 1;
+    pthread_mutex_lock(&outputLock);
+    bool room = outputStreamCount + count <= MAX_OUTPUT_STREAMS;
+    if (room) {
+        atomic_store(&ring->openStreams, count);
+        int fds[2] = { errFd, outFd };
+        for (int i = 0; i < count; i++) {
+            fcntl(fds[i], F_SETFL, O_NONBLOCK);
+            newOutputStreams[newOutputStreamCount].fd = fds[i];
+            newOutputStreams[newOutputStreamCount].stream = i == 0 ? STREAM_STDERR : STREAM_STDOUT;
+            newOutputStreams[newOutputStreamCount].ring = ring;
+            newOutputStreamCount++;
+        }
+        outputStreamCount += count;
+    }
+    pthread_mutex_unlock(&outputLock);
+
+    if (!room) {
+        close(errFd);
+        if (outFd >= 0) {
+            close(outFd);
+        }
+        // No reader owns the ring, so this thread may still write to it
+        const char* message = "Too many scripts are holding output pipes open; output not captured.\n";
+        OutputRingWrite(ring, STREAM_STDERR, message, strlen(message));
+        atomic_store(&ring->closed, true);
+        return;
+    }
+
+    char wake = 1;
+    ssize_t ignored = write(outputWakePipe[1], &wake, 1);
+    (void)ignored;
+}
+
+// Reads every captured pipe into its job's ring. A full ring only pauses
+// that pipe (the script then blocks on its own write); nothing here ever
+// waits on the frame loop.
+void* OutputReaderThread(void* arg) {
+    (void)arg;
+    OutputStream streams[MAX_OUTPUT_STREAMS];
+    int streamCount = 0;
+    struct pollfd fds[MAX_OUTPUT_STREAMS + 1];
+    int polled[MAX_OUTPUT_STREAMS + 1];
+
+    while (1) {
+        pthread_mutex_lock(&outputLock);
+        while (newOutputStreamCount > 0 && streamCount < MAX_OUTPUT_STREAMS) {
+            streams[streamCount++] = newOutputStreams[--newOutputStreamCount];
+        }
+        pthread_mutex_unlock(&outputLock);
+
+        int count = 0;
+        bool throttled = false;
+        fds[count].fd = outputWakePipe[0];
+        fds[count].events = POLLIN;
+        polled[count++] = -1;
+        for (int i = 0; i < streamCount; i++) {
+            if (OutputRingSpace(streams[i].ring) == 0) {
+                throttled = true;  // retry once the frame loop has drained it
+                continue;
+            }
+            fds[count].fd = streams[i].fd;
+            fds[count].events = POLLIN;
+            polled[count++] = i;
+        }
+
+        poll(fds, count, throttled ? 10 : -1);
+
+        if (fds[0].revents & POLLIN) {
+            char drain[64];
+            ssize_t ignored = read(outputWakePipe[0], drain, sizeof(drain));
+            (void)ignored;
+        }
+
+        for (int p = count - 1; p > 0; p--) {
+            if (!(fds[p].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            OutputStream* stream = &streams[polled[p]];
+            char buffer[OUTPUT_CHUNK];
+            size_t space = OutputRingSpace(stream->ring);
+            ssize_t length = read(stream->fd, buffer, space < sizeof(buffer) ? space : sizeof(buffer));
+            if (length > 0) {
+                OutputRingWrite(stream->ring, stream->stream, buffer, (size_t)length);
+            } else if (length == 0 || (errno != EAGAIN && errno != EINTR)) {
+                // EOF: the last stream of a ring closes it for the consumer
+                close(stream->fd);
+                pthread_mutex_lock(&outputLock);
+                outputStreamCount--;
+                pthread_mutex_unlock(&outputLock);
+                if (atomic_fetch_sub(&stream->ring->openStreams, 1) == 1) {
+                    atomic_store(&stream->ring->closed, true);
+                }
+                streams[polled[p]] = streams[--streamCount];
+            }
+        }
+        if (count > 1) {
+            WakeFrameLoop();
+        }
+    }
+    return NULL;
+}
+
+void StartOutputReader() {
+    if (OpenPipe(outputWakePipe) != 0) {
+        printf("Could not start the output reader.\n");
+        return;
+    }
+    fcntl(outputWakePipe[0], F_SETFL, O_NONBLOCK);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, OutputReaderThread, NULL);
+    pthread_detach(thread);
+}
+
+// Read exactly length bytes from a worker, false on EOF or error
+bool ReadFully(int fd, void* buffer, size_t length) {
+    char* out = buffer;
+    while (length > 0) {
+        ssize_t got = read(fd, out, length);
+        if (got <= 0) {
+            if (got < 0 && errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        out += got;
+        length -= (size_t)got;
+    }
+    return true;
+}
+
+// Start one interpreter running pythonWorkerSource, -1 on failure
+int StartPythonInterpreter(int* toWorker, int* fromWorker) {
+    int request[2], reply[2];
+    if (OpenPipe(request) != 0) {
+        return -1;
+    }
+    if (OpenPipe(reply) != 0) {
+        close(request[0]);
+        close(request[1]);
+        return -1;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, request[0], 0);
+    posix_spawn_file_actions_adddup2(&actions, reply[1], 1);
+    posix_spawn_file_actions_addclose(&actions, request[0]);
+    posix_spawn_file_actions_addclose(&actions, reply[1]);
+    char* argv[] = { PYTHON_PROGRAM, "-u", "-c", (char*)pythonWorkerSource, NULL };
+    extern char** environ;
+    pid_t pid;
+    atomic_fetch_add(&spawnCalls, 1);
+    if (posix_spawnp(&pid, PYTHON_PROGRAM, &actions, NULL, argv, environ) != 0) {
+        pid = -1;
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    close(request[0]);
+    close(reply[1]);
+
+    if (pid <= 0) {
+        close(request[1]);
+        close(reply[0]);
+        return -1;
+    }
+    *toWorker = request[1];
+    *fromWorker = reply[0];
+    return pid;
+}
+
+// Owns one warm interpreter, started up front so the first run is already
+// fast, and restarted as soon as it dies (os._exit, a crash, ...)
+void* PythonWorkerThread(void* arg) {
+    (void)arg;
+    int toWorker = -1;
+    int fromWorker = -1;
+    pid_t pid = StartPythonInterpreter(&toWorker, &fromWorker);
+
+    while (1) {
+        pthread_mutex_lock(&processLock);
+        ProcessJob* job = NULL;
+        while (!job) {
+            // Oldest queued warm job first
+            for (int i = 0; i < MAX_PROCESS_JOBS && !job; i++) {
+                ProcessJob* candidate = &processJobs[(nextWarmHandle + i) % MAX_PROCESS_JOBS];
+                if (candidate->warm && candidate->state == PROCESS_QUEUED) {
+                    job = candidate;
+                }
+            }
+            if (!job) {
+                pthread_cond_wait(&pythonWorkReady, &processLock);
+            }
+        }
+        job->state = PROCESS_RUNNING;
+        job->startedAt = NowSeconds();
+        nextWarmHandle = job->handle + 1;
+        WakeFrameLoop();
+        char path[256];
+        snprintf(path, sizeof(path), "%s\n", job->argv[0]);
+        pthread_mutex_unlock(&processLock);
+
+        if (pid <= 0) {
+            pid = StartPythonInterpreter(&toWorker, &fromWorker);
+        }
+
+        int exitCode = 127;
+        bool finished = false;
+        if (pid > 0 && write(toWorker, path, strlen(path)) == (ssize_t)strlen(path)) {
+            unsigned char header[5];
+            while (ReadFully(fromWorker, header, sizeof(header))) {
+                uint32_t length = header[1] | (header[2] << 8) | (header[3] << 16) | ((uint32_t)header[4] << 24);
+                if (header[0] == 'x') {
+                    int32_t code = 0;
+                    if (length == 4 && ReadFully(fromWorker, &code, 4)) {
+                        exitCode = code;
+                        finished = true;
+                    }
+                    break;
+                }
+                // Pass the output on in ring-sized pieces, waiting for the
+                // frame loop to drain when the ring is full
+                char buffer[OUTPUT_CHUNK];
+                bool readOk = true;
+                while (length > 0 && readOk) {
+                    uint32_t piece = length < sizeof(buffer) ? length : sizeof(buffer);
+                    readOk = ReadFully(fromWorker, buffer, piece);
+                    while (readOk && job->output &&
+                            !OutputRingWrite(job->output, header[0] == 'e' ? STREAM_STDERR : STREAM_STDOUT, buffer, piece)) {
+                        usleep(1000);
+                    }
+                    WakeFrameLoop();
+                    length -= piece;
+                }
+                if (!readOk) {
+                    break;
+                }
+            }
+        }
+
+        if (!finished) {
+            // The interpreter is gone; report how it ended and start a new one next time
+            if (pid > 0) {
+                close(toWorker);
+                close(fromWorker);
+                int status = 0;
+                waitpid(pid, &status, 0);
+                exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+                pid = StartPythonInterpreter(&toWorker, &fromWorker);
+            }
+            const char* message = "The Python worker exited during this run.\n";
+            if (exitCode == 127) {
+                message = "Could not start a Python worker.\n";
+            }
+            if (job->output) {
+                OutputRingWrite(job->output, STREAM_STDERR, message, strlen(message));
+            }
+        }
+        if (job->output) {
+            atomic_store(&job->output->closed, true);
+        }
+
+        pthread_mutex_lock(&processLock);
+        job->exitCode = exitCode;
+        RecordRun(job);
+        job->state = PROCESS_DONE;
+        pthread_mutex_unlock(&processLock);
+        WakeFrameLoop();
+    }
+    return NULL;
+}
+
+void StartPythonWorkers() {
+    for (int i = 0; i < pythonWorkers; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, PythonWorkerThread, NULL);
+        pthread_detach(thread);
+    }
+}
+
+void StartProcessPool() {
+    StartOutputReader();
+    if (OpenPipe(processWakePipe) != 0) {
+        printf("Could not create the process pool.\n");
+        return;
+    }
+    fcntl(processWakePipe[0], F_SETFL, O_NONBLOCK);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, ProcessReaperThread, NULL);
+    pthread_detach(thread);
+}
+#else
+// Windows has no posix_spawn: maxRunningProcesses threads each run one job
+// at a time with _spawnvp, which also avoids the shell
+void* ProcessReaperThread(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&processLock);
+        while (nextStartHandle >= nextProcessHandle) {
+            pthread_cond_wait(&processReady, &processLock);
+        }
+        ProcessJob* job = &processJobs[nextStartHandle % MAX_PROCESS_JOBS];
+        nextStartHandle++;
+        if (job->state != PROCESS_QUEUED) {
+            pthread_mutex_unlock(&processLock);
+            continue;
+        }
+        job->state = PROCESS_RUNNING;
+        job->startedAt = NowSeconds();
+        runningProcesses++;
+        pthread_mutex_unlock(&processLock);
+        WakeFrameLoop();
+
+        // No capture here, the script writes to the app's console
+        if (job->output) {
+            atomic_store(&job->output->closed, true);
+        }
+        atomic_fetch_add(&spawnCalls, 1);
+        intptr_t result = _spawnvp(_P_WAIT, job->argv[0], (const char* const*)job->argv);
+
+        pthread_mutex_lock(&processLock);
+        job->exitCode = (result == -1) ? 127 : (int)result;
+        RecordRun(job);  // wall time only, no rusage here
+        job->state = PROCESS_DONE;
+        runningProcesses--;
+        pthread_mutex_unlock(&processLock);
+        WakeFrameLoop();
+    }
+    return NULL;
+}
+
+// Warm workers need pipes on stdin/stdout, which _spawnvp cannot set up
+void StartPythonWorkers() {
+    if (pythonWorkers > 0) {
+        printf("Warm Python workers are not available on Windows, scripts start a new interpreter.\n");
+        pythonWorkers = 0;
+    }
+}
+
+void StartProcessPool() {
+    for (int i = 0; i < maxRunningProcesses; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, ProcessReaperThread, NULL);
+        pthread_detach(thread);
+    }
+}
+#endif
+
+// Start a script with its output captured into the script's console
+int RunScriptProcess(const char* const* argv, int scriptNumber) {
+    // A Python script that only exists encoded runs as "python -" with its
+    // decoded text on stdin
+    if (strcmp(argv[0], PYTHON_PROGRAM) == 0 && argv[1] && !DoesFileExist(argv[1])) {
+        char encoded[128];
+        snprintf(encoded, sizeof(encoded), "%s.txt", argv[1]);
+        size_t length;
+        char* input = DoesFileExist(encoded) ? CopyScriptSource(GetScript(scriptNumber), argv[1], &length) : NULL;
+        if (input) {
+            const char* stdinArgv[] = { PYTHON_PROGRAM, "-", NULL };
+            return RunScriptWithInput(stdinArgv, scriptNumber, input, length);
+        }
+    }
+    return RunScriptWithInput(argv, scriptNumber, NULL, 0);
+}
+
+#ifndef _WIN32
+typedef struct {
+    int fd;
+    char* input;
+    size_t length;
+} InputFeed;
+
+// Write a script's input into its stdin pipe, then close it so the
+// reader sees end of file. A reader that exits early ends the write with
+// EPIPE (SIGPIPE is ignored).
+void* FeedInputThread(void* arg) {
+    InputFeed* feed = arg;
+    size_t written = 0;
+    while (written < feed->length) {
+        ssize_t count = write(feed->fd, feed->input + written, feed->length - written);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            break;
+        }
+        written += count;
+    }
+    close(feed->fd);
+    free(feed->input);
+    free(feed);
+    return NULL;
+}
+#endif
+
+// RunScriptProcess with the given bytes as the script's stdin, or the
+// usual inherited stdin for NULL. Takes ownership of input.
+int RunScriptWithInput(const char* const* argv, int scriptNumber, char* input, size_t length) {
+    Script* script = GetScript(scriptNumber);
+    Console* console = GetConsole(script);
+    char banner[CONSOLE_LINE_LENGTH];
+    snprintf(banner, sizeof(banner), "$ %s\n", argv[0]);
+    ConsoleAppend(console, banner, strlen(banner), false);
+
+    OutputRing* ring = NULL;
+    if (activeOutputCount < MAX_ACTIVE_OUTPUTS) {
+        ring = calloc(1, sizeof(OutputRing));
+    }
+    int handle = 0;
+    if (input) {
+#ifdef _WIN32
+        printf("Encoded Python scripts need posix_spawn and cannot run on Windows.\n");
+        free(input);
+#else
+        int fds[2] = { -1, -1 };
+        if (OpenPipe(fds) == 0) {
+            pthread_mutex_lock(&processLock);
+            ProcessJob* job = ClaimProcessJob(argv, scriptNumber, ring);
+            if (job) {
+                job->stdinFd = fds[0];
+                handle = job->handle;
+                pthread_cond_broadcast(&processReady);
+            }
+            pthread_mutex_unlock(&processLock);
+        }
+        if (handle) {
+            char wake = 1;
+            ssize_t ignored = write(processWakePipe[1], &wake, 1);
+            (void)ignored;
+            InputFeed* feed = malloc(sizeof(InputFeed));
+            pthread_t thread;
+            if (feed) {
+                feed->fd = fds[1];
+                feed->input = input;
+                feed->length = length;
+            }
+            if (!feed || pthread_create(&thread, NULL, FeedInputThread, feed) != 0) {
+                // The script sees the end of its input instead of waiting for it
+                close(fds[1]);
+                free(feed);
+                free(input);
+            } else {
+                pthread_detach(thread);
+            }
+        } else {
+            if (fds[0] >= 0) {
+                close(fds[0]);
+                close(fds[1]);
+            }
+            free(input);
+        }
+#endif
+    } else if (pythonWorkers > 0 && strcmp(argv[0], PYTHON_PROGRAM) == 0) {
+        handle = SubmitWarmPython(argv[1], scriptNumber, ring);
+    } else {
+        handle = SubmitProcess(argv, scriptNumber, ring);
+    }
+    if (handle == 0) {
+        free(ring);
+        return 0;
+    }
+    if (ring) {
+        activeOutputs[activeOutputCount].ring = ring;
+        activeOutputs[activeOutputCount].scriptNumber = scriptNumber;
+        activeOutputs[activeOutputCount].handle = handle;
+        activeOutputCount++;
+    }
+    script->runJob = handle;
+    console->scroll = 0;
+    return handle;
+}
+
+// Move everything the reader produced into the script consoles and free
+// rings whose processes are done, ending each with the run's usage.
+// Consumer side of the rings. Returns true if any console changed.
+bool PumpScriptOutput() {
+    bool changed = false;
+    for (int i = 0; i < activeOutputCount; i++) {
+        OutputRing* ring = activeOutputs[i].ring;
+        bool closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+        size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        Console* console = GetConsole(GetScript(activeOutputs[i].scriptNumber));
+
+        while (tail != head) {
+            int stream = (unsigned char)ring->data[tail & (OUTPUT_RING_SIZE - 1)];
+            size_t length = (unsigned char)ring->data[(tail + 1) & (OUTPUT_RING_SIZE - 1)]
+                          | ((size_t)(unsigned char)ring->data[(tail + 2) & (OUTPUT_RING_SIZE - 1)] << 8);
+            char chunk[OUTPUT_CHUNK];
+            for (size_t j = 0; j < length; j++) {
+                chunk[j] = ring->data[(tail + 3 + j) & (OUTPUT_RING_SIZE - 1)];
+            }
+            ConsoleAppend(console, chunk, length, stream == STREAM_STDERR);
+            tail += 3 + length;
+            changed = true;
+        }
+        atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+        if (closed && tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+            // The pipes can close before the process is reaped
+            RunRecord record;
+            int state = GetProcessRecord(activeOutputs[i].handle, &record);
+            if (state == PROCESS_QUEUED || state == PROCESS_RUNNING) {
+                continue;
+            }
+            if (state == PROCESS_DONE) {
+                char summary[CONSOLE_LINE_LENGTH];
+                if (record.flags & RUN_TIMED_OUT) {
+                    snprintf(summary, sizeof(summary), "[killed after the %.0f s timeout]\n", runTimeout);
+                } else if (record.flags & RUN_WARM) {
+                    snprintf(summary, sizeof(summary), "[exit %d, %.2f s]\n", record.exitCode, record.wallSeconds);
+                } else {
+                    snprintf(summary, sizeof(summary), "[exit %d, %.2f s, %.2f s CPU, %.1f MB peak]\n",
+                            record.exitCode, record.wallSeconds, record.cpuSeconds, record.maxRssKb / 1024.0);
+                }
+                ConsoleAppend(console, summary, strlen(summary), false);
+                changed = true;
+            }
+            free(ring);
+            activeOutputs[i--] = activeOutputs[--activeOutputCount];
+        }
+    }
+    return changed;
+}
+
+Console* GetConsole(Script* script) {
+    if (!script->console) {
+        script->console = calloc(1, sizeof(Console));
+    }
+    return script->console;
+}
+
+// Split output into lines; stdout and stderr never share a line
+void ConsoleAppend(Console* console, const char* data, size_t length, bool isError) {
+    for (size_t i = 0; i < length; i++) {
+        char c = data[i];
+        if (c == '\r') {
+            continue;
+        }
+        int last = (console->first + console->count - 1) % CONSOLE_MAX_LINES;
+        if (!console->lineOpen || console->isError[last] != isError) {
+            // Start a new line, recycling the oldest once the scrollback is full
+            int slot;
+            if (console->count < CONSOLE_MAX_LINES) {
+                slot = (console->first + console->count) % CONSOLE_MAX_LINES;
+                console->count++;
+            } else {
+                slot = console->first;
+                console->first = (console->first + 1) % CONSOLE_MAX_LINES;
+                console->truncated = true;
+            }
+            if (!console->lines[slot]) {
+                console->lines[slot] = malloc(CONSOLE_LINE_LENGTH);
+            }
+            console->lines[slot][0] = '\0';
+            console->isError[slot] = isError;
+            console->lineOpen = true;
+            last = slot;
+        }
+        if (c == '\n') {
+            console->lineOpen = false;
+            continue;
+        }
+        size_t used = strlen(console->lines[last]);
+        if (used < CONSOLE_LINE_LENGTH - 1) {
+            console->lines[last][used] = (c == '\t') ? ' ' : c;
+            console->lines[last][used + 1] = '\0';
+        } else {
+            console->truncated = true;
+        }
+    }
+}
+
+void DrawConsolePanel(Script* script, int x, int y, int width, int height) {
+    Console* console = script->console;
+    DrawRectangle(x, y, width, height, BLACK);
+    DrawRectangleLines(x, y, width, height, DARKGRAY);
+
+    char* lastSlash = strrchr(script->filename, '/');
+    DrawText(TextFormat("CONSOLE: %s  [PgUp/PgDn] scroll", lastSlash ? lastSlash + 1 : script->filename),
+            x + 5, y + 5, CONSOLE_FONT_SIZE, LIGHTGRAY);
+
+    int visible = (height - 30) / CONSOLE_LINE_HEIGHT;
+    if (visible <= 0 || !console) {
+        return;
+    }
+    int maxScroll = console->count > visible ? console->count - visible : 0;
+    if (console->scroll > maxScroll) {
+        console->scroll = maxScroll;
+    }
+
+    // Newest lines at the bottom, shifted up by the scroll offset
+    int last = console->count - 1 - console->scroll;
+    int firstShown = last - visible + 1 < 0 ? 0 : last - visible + 1;
+    BeginScissorMode(x, y + 25, width, height - 25);
+    for (int i = firstShown; i <= last; i++) {
+        int slot = (console->first + i) % CONSOLE_MAX_LINES;
+        DrawText(console->lines[slot], x + 5, y + 28 + (i - firstShown) * CONSOLE_LINE_HEIGHT,
+                CONSOLE_FONT_SIZE, console->isError[slot] ? RED : RAYWHITE);
+    }
+    EndScissorMode();
+}
+
+void OpenScriptInNotepad(const char* filename) {
+    ExtractPackedFile(filename);
+    const char* argv[] = { EDITOR_PROGRAM, filename, NULL };
+    SubmitProcess(argv, 0, NULL);
+}
+
+void ExecutePythonScript(const char* filename) {
+    bool isC;
+    int scriptNumber = ParseScriptFilename(filename, &isC);
+    const char* argv[] = { PYTHON_PROGRAM, filename, NULL };
+    ExtractPackedFile(filename);
+    if (scriptNumber > 0) {
+        RunScriptProcess(argv, scriptNumber);
+    } else {
+        SubmitProcess(argv, 0, NULL);
+    }
+}
+
+void CompileAndExecuteCFile(const char* filename) {
+    bool isC;
+    int scriptNumber = ParseScriptFilename(filename, &isC);
+    if (scriptNumber == 0) {
+        return;
+    }
+    QueueCompileJob(scriptNumber, filename, false, false);
+}
+
+// Hand a compile to the worker pool. One compile per script at a time;
+// returns false if this script is already being built.
+bool QueueCompileJob(int scriptNumber, const char* source, bool buildOnly, bool batch) {
+    Script* script = GetScript(scriptNumber);
+    if (script->compileState == COMPILE_BUSY) {
+        return false;
+    }
+    script->compileState = COMPILE_BUSY;
+    ExtractPackedFile(source);
+
+    // The worker picks the output name from the build cache key
+    CompileJob* job = calloc(1, sizeof(CompileJob));
+    job->scriptNumber = scriptNumber;
+    job->buildOnly = buildOnly;
+    job->batch = batch;
+    snprintf(job->source, sizeof(job->source), "%s", source);
+    if (!DoesFileExist(source)) {
+        job->input = CopyScriptSource(script, source, &job->inputLength);
+    }
+
+    pthread_mutex_lock(&compileLock);
+    if (pendingTail) {
+        pendingTail->next = job;
+    } else {
+        pendingHead = job;
+    }
+    pendingTail = job;
+    pendingCompileCount++;
+    pthread_cond_signal(&compileReady);
+    pthread_mutex_unlock(&compileLock);
+    return true;
+}
+
+// Compile every C script of one grid, or of all grids for -1, without
+// running them. Targets whose source and local headers are unchanged hit
+// the build cache, so only out-of-date scripts reach gcc. Returns the
+// number of scripts queued.
+int BuildAllScripts(int gridIndex) {
+    if (buildBatchActive) {
+        return 0;
+    }
+
+    // Collect first: queueing takes slotLock again through GetScript
+    int capacity = 64;
+    int count = 0;
+    int* numbers = malloc(capacity * sizeof(int));
+    pthread_mutex_lock(&slotLock);
+    for (int i = 0; i < slotCapacity; i++) {
+        Script* script = slotTable[i];
+        if (!script || !(script->status.flags & STATUS_C)) {
+            continue;
+        }
+        if (gridIndex >= 0 && (script->number - 1) / scriptsPerGrid != gridIndex) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            numbers = realloc(numbers, capacity * sizeof(int));
+        }
+        numbers[count++] = script->number;
+    }
+    pthread_mutex_unlock(&slotLock);
+    qsort(numbers, count, sizeof(int), CompareUnsigned);
+
+    free(buildResults);
+    buildResults = malloc((count > 0 ? count : 1) * sizeof(BuildResult));
+    buildResultCount = 0;
+    buildBatchTotal = 0;
+    buildBatchFailed = 0;
+    buildBatchUpToDate = 0;
+    free(buildSkipped);
+    buildSkipped = malloc((count > 0 ? count : 1) * sizeof(int));
+    buildSkippedCount = 0;
+    buildBatchStart = NowSeconds();
+
+    for (int i = 0; i < count; i++) {
+        char source[100];
+        snprintf(source, sizeof(source), GAME_FILES_PATH "script%d.c", numbers[i]);
+        if (QueueCompileJob(numbers[i], source, true, true)) {
+            buildBatchTotal++;
+        } else {
+            buildSkipped[buildSkippedCount++] = numbers[i];
+        }
+    }
+    free(numbers);
+    buildBatchActive = buildBatchTotal > 0;
+    if (!buildBatchActive && buildSkippedCount > 0) {
+        FinishBuildReport();  // nothing to wait for, but say what was left out
+    }
+    return buildBatchTotal;
+}
+
+// Print the finished batch and keep a copy next to the build cache
+void FinishBuildReport() {
+    buildBatchActive = false;
+    for (int i = 1; i < buildResultCount; i++) {
+        BuildResult result = buildResults[i];
+        int j = i - 1;
+        while (j >= 0 && buildResults[j].scriptNumber > result.scriptNumber) {
+            buildResults[j + 1] = buildResults[j];
+            j--;
+        }
+        buildResults[j + 1] = result;
+    }
+
+    FILE* report = ProfiledFopen(BUILD_CACHE_PATH "report.txt", "w");
+    for (int i = 0; i < buildResultCount; i++) {
+        BuildResult* result = &buildResults[i];
+        const char* state = result->exitCode != 0 ? "FAILED" : (result->cached ? "up to date" : "built");
+        printf("script%d.c: %s (%.2f s)\n", result->scriptNumber, state, result->seconds);
+        if (result->error[0]) {
+            printf("    %s\n", result->error);
+        }
+        if (report) {
+            fprintf(report, "script%d.c: %s (%.2f s)\n", result->scriptNumber, state, result->seconds);
+            if (result->error[0]) {
+                fprintf(report, "    %s\n", result->error);
+            }
+        }
+    }
+    // Already compiling when the batch started; that build reports itself
+    for (int i = 0; i < buildSkippedCount; i++) {
+        printf("script%d.c: skipped, already compiling\n", buildSkipped[i]);
+        if (report) {
+            fprintf(report, "script%d.c: skipped, already compiling\n", buildSkipped[i]);
+        }
+    }
+    double elapsed = NowSeconds() - buildBatchStart;
+    printf("Built %d scripts in %.2f s on %d workers: %d up to date, %d failed, %d skipped.\n",
+            buildResultCount, elapsed, compileWorkers, buildBatchUpToDate, buildBatchFailed, buildSkippedCount);
+    if (report) {
+        fprintf(report, "Built %d scripts in %.2f s on %d workers: %d up to date, %d failed, %d skipped.\n",
+                buildResultCount, elapsed, compileWorkers, buildBatchUpToDate, buildBatchFailed, buildSkippedCount);
+        fclose(report);
+    }
+}
+
+// --build-all: compile every C script without opening a window.
+// Exits non-zero if any script failed to build.
+int BuildAllHeadless() {
+    InitializeAndLoadExistingScripts();
+    StartCompileWorkers();
+    if (BuildAllScripts(-1) == 0) {
+        printf("No C scripts to build.\n");
+        return 0;
+    }
+    while (buildBatchActive) {
+        atomic_store(&uiChanged, false);
+        PollCompileJobs();
+        WaitForActivity(100);
+    }
+    return buildBatchFailed > 0 ? 1 : 0;
+}
+
+// One script of a --run batch
+typedef struct {
+    int scriptNumber;
+    int state;  // BATCH_*
+    int handle;
+    bool buildFailed;
+    bool startFailed;  // built, but the run could not be started
+    bool reported;     // counted and printed
+    RunRecord record;
+} BatchItem;
+
+// --run: compile and run the scripts named by spec without a window, at
+// most -j at a time, and write a JSON report. Scripts map to files exactly
+// as on the grid. Exits non-zero if any build or run failed.
+int RunBatchHeadless(const char* spec, const char* reportPath) {
+    InitializeAndLoadExistingScripts();
+    LoadRunHistory();
+    StartCompileWorkers();
+    StartProcessPool();
+    StartPythonWorkers();
+
+    int* numbers = NULL;
+    int count = ParseRunSpec(spec, &numbers);
+    if (count < 0) {
+        printf("Run ranges look like 3,10-20 for scripts or g1-2 for whole grids.\n");
+        return 2;
+    }
+    BatchItem* items = calloc(count > 0 ? count : 1, sizeof(BatchItem));
+    for (int i = 0; i < count; i++) {
+        items[i].scriptNumber = numbers[i];
+    }
+    free(numbers);
+
+    // Keep the process table and output rings from filling up: only a
+    // bounded number of scripts are building or running at once
+    int limit = maxRunningProcesses + compileWorkers;
+    int done = 0;
+    int failed = 0;
+    double started = NowSeconds();
+    while (done < count) {
+        atomic_store(&uiChanged, false);
+        PollCompileJobs();
+        PumpScriptOutput();
+
+        int inFlight = 0;
+        for (int i = 0; i < count; i++) {
+            BatchItem* item = &items[i];
+            Script* script = GetScript(item->scriptNumber);
+            if (item->state == BATCH_WAITING && inFlight < limit) {
+                script->runJob = 0;
+                if (script->isCFile) {
+                    QueueCompileJob(item->scriptNumber, script->filename, false, false);
+                    item->state = BATCH_BUILDING;
+                } else {
+                    const char* argv[] = { PYTHON_PROGRAM, script->filename, NULL };
+                    ExtractPackedFile(script->filename);
+                    item->handle = RunScriptProcess(argv, item->scriptNumber);
+                    item->state = item->handle ? BATCH_RUNNING : BATCH_WAITING;
+                }
+            }
+            if (item->state == BATCH_BUILDING && script->compileState == COMPILE_FAILED) {
+                item->buildFailed = true;
+                item->state = BATCH_DONE;
+            } else if (item->state == BATCH_BUILDING && script->compileState == COMPILE_OK) {
+                // PollCompileJobs starts the run as soon as the build is
+                // done, so no job here means it could not be started
+                item->handle = script->runJob;
+                item->startFailed = item->handle == 0;
+                item->state = item->handle ? BATCH_RUNNING : BATCH_DONE;
+            }
+            if (item->state == BATCH_RUNNING && GetProcessRecord(item->handle, &item->record) == PROCESS_DONE &&
+                    !IsOutputPending(item->handle)) {
+                item->state = BATCH_DONE;
+            }
+
+            if (item->state == BATCH_DONE && !item->reported) {
+                bool ok = !item->buildFailed && !item->startFailed && item->record.exitCode == 0 &&
+                    !(item->record.flags & RUN_TIMED_OUT);
+                printf("script%d: %s\n", item->scriptNumber, ok ? "ok" : "FAILED");
+                failed += !ok;
+                done++;
+                item->reported = true;
+            } else if (item->state == BATCH_BUILDING || item->state == BATCH_RUNNING) {
+                inFlight++;
+            }
+        }
+        if (done < count) {
+            WaitForActivity(50);
+        }
+    }
+
+    FILE* report = ProfiledFopen(reportPath, "w");
+    if (!report) {
+        printf("Could not write %s.\n", reportPath);
+        free(items);
+        return 2;
+    }
+    fprintf(report, "{\n  \"seconds\": %.3f,\n  \"scripts\": %d,\n  \"failed\": %d,\n  \"results\": [",
+            NowSeconds() - started, count, failed);
+    for (int i = 0; i < count; i++) {
+        BatchItem* item = &items[i];
+        Script* script = GetScript(item->scriptNumber);
+        const char* status = "ok";
+        if (item->buildFailed) {
+            status = "build_failed";
+        } else if (item->startFailed) {
+            status = "start_failed";
+        } else if (item->record.flags & RUN_TIMED_OUT) {
+            status = "timed_out";
+        } else if (item->record.exitCode != 0) {
+            status = "failed";
+        }
+        fprintf(report, "%s\n    {\"script\": %d, \"grid\": %d, \"slot\": %d, \"file\": ", i ? "," : "",
+                script->number, (script->number - 1) / scriptsPerGrid + 1, (script->number - 1) % scriptsPerGrid + 1);
+        WriteJsonString(report, script->filename, false, NULL);
+        fprintf(report, ", \"status\": \"%s\", \"build_seconds\": %.3f, \"exit_code\": %d, "
+                "\"wall_seconds\": %.3f, \"cpu_seconds\": %.3f, \"max_rss_kb\": %d,\n     \"stdout\": ",
+                status, script->isCFile ? script->buildSeconds : 0.0f,
+                item->buildFailed || item->startFailed ? -1 : item->record.exitCode,
+                item->record.wallSeconds, item->record.cpuSeconds, (int)item->record.maxRssKb);
+        WriteJsonString(report, NULL, false, script->console);
+        fprintf(report, ",\n     \"stderr\": ");
+        WriteJsonString(report, NULL, true, script->console);
+        // stdout and stderr keep CONSOLE_MAX_LINES lines of up to
+        // CONSOLE_LINE_LENGTH characters; this says whether any were cut
+        fprintf(report, ",\n     \"truncated\": %s}", script->console && script->console->truncated ? "true" : "false");
+    }
+    fprintf(report, "\n  ]\n}\n");
+    fclose(report);
+
+    printf("Ran %d scripts in %.2f s, %d failed. Report: %s\n", count, NowSeconds() - started, failed, reportPath);
+    free(items);
+    return failed > 0 ? 1 : 0;
+}
+
+// Script numbers with a file that fall in spec: comma separated numbers
+// or ranges of them ("3,10-20"), or grids with a g prefix ("g1-2").
+// Returns how many, sorted, or -1 if spec does not parse.
+int ParseRunSpec(const char* spec, int** numbers) {
+    int rangeCount = 0;
+    int ranges[64][2];
+    const char* cursor = spec;
+    while (*cursor && rangeCount < 64) {
+        bool grid = *cursor == 'g';
+        cursor += grid;
+        char* end;
+        long first = strtol(cursor, &end, 10);
+        long last = first;
+        if (end == cursor || first < 1) {
+            return -1;
+        }
+        if (*end == '-') {
+            cursor = end + 1;
+            last = strtol(cursor, &end, 10);
+            if (end == cursor || last < first) {
+                return -1;
+            }
+        }
+        if (*end != ',' && *end != '\0') {
+            return -1;
+        }
+        if (grid) {
+            first = (first - 1) * scriptsPerGrid + 1;
+            last = last * scriptsPerGrid;
+        }
+        ranges[rangeCount][0] = first > MAX_SCRIPT_NUMBER ? MAX_SCRIPT_NUMBER : (int)first;
+        ranges[rangeCount][1] = last > MAX_SCRIPT_NUMBER ? MAX_SCRIPT_NUMBER : (int)last;
+        rangeCount++;
+        cursor = *end ? end + 1 : end;
+    }
+
+    // Walk the slot table rather than the ranges, which may span whole grids
+    int capacity = 64;
+    int count = 0;
+    *numbers = malloc(capacity * sizeof(int));
+    pthread_mutex_lock(&slotLock);
+    for (int i = 0; i < slotCapacity; i++) {
+        Script* script = slotTable[i];
+        if (!script || !ScriptFileExists(script)) {
+            continue;
+        }
+        bool wanted = false;
+        for (int r = 0; r < rangeCount && !wanted; r++) {
+            wanted = script->number >= ranges[r][0] && script->number <= ranges[r][1];
+        }
+        if (!wanted) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            *numbers = realloc(*numbers, capacity * sizeof(int));
+        }
+        (*numbers)[count++] = script->number;
+    }
+    pthread_mutex_unlock(&slotLock);
+    qsort(*numbers, count, sizeof(int), CompareUnsigned);
+    return count;
+}
+
+// A ring for this job is still waiting to be drained into its console
+bool IsOutputPending(int handle) {
+    for (int i = 0; i < activeOutputCount; i++) {
+        if (activeOutputs[i].handle == handle) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Write text as a JSON string, or with console set, that console's stdout
+// (or stderr) lines joined by newlines
+void WriteJsonString(FILE* file, const char* text, bool errors, const Console* console) {
+    fputc('"', file);
+    int lines = console ? console->count : 1;
+    for (int line = 0; line < lines; line++) {
+        const char* c = text;
+        if (console) {
+            int slot = (console->first + line) % CONSOLE_MAX_LINES;
+            if (console->isError[slot] != errors) {
+                continue;
+            }
+            c = console->lines[slot];
+        }
+        for (; *c; c++) {
+            if (*c == '"' || *c == '\\') {
+                fprintf(file, "\\%c", *c);
+            } else if ((unsigned char)*c < 0x20) {
+                fprintf(file, "\\u%04x", (unsigned char)*c);
+            } else {
+                fputc(*c, file);
+            }
+        }
+        if (console) {
+            fputs("\\n", file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Ctrl+click adds a script to the end of the draft pipeline, or takes it out
+void TogglePipelineStage(int scriptNumber) {
+    int position = PipelineStageOf(scriptNumber);
+    if (position >= 0) {
+        memmove(&pipelineDraft.stages[position], &pipelineDraft.stages[position + 1],
+                (pipelineDraft.stageCount - position - 1) * sizeof(int));
+        pipelineDraft.stageCount--;
+    } else if (pipelineDraft.stageCount < MAX_PIPELINE_STAGES) {
+        pipelineDraft.stages[pipelineDraft.stageCount++] = scriptNumber;
+    }
+}
+
+// Position of a script in the draft pipeline, -1 if it is not in it
+int PipelineStageOf(int scriptNumber) {
+    for (int i = 0; i < pipelineDraft.stageCount; i++) {
+        if (pipelineDraft.stages[i] == scriptNumber) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Compile the pipeline's C stages; PollPipeline launches it once they are
+// built. Returns false if another pipeline is still going.
+bool StartPipeline(const int* stages, int count, bool headless) {
+    if (activePipeline.building || activePipeline.running || count < 1) {
+        return false;
+    }
+#ifdef _WIN32
+    printf("Pipelines need posix_spawn and are not available on Windows.\n");
+    return false;
+#endif
+    memset(&activePipeline, 0, sizeof(activePipeline));
+    memcpy(activePipeline.stages, stages, count * sizeof(int));
+    activePipeline.stageCount = count;
+    activePipeline.headless = headless;
+    activePipeline.building = true;
+    for (int i = 0; i < count; i++) {
+        Script* script = GetScript(stages[i]);
+        if (script->isCFile) {
+            QueueCompileJob(stages[i], script->filename, true, false);
+        }
+    }
+    return true;
+}
+
+// Frame loop side: launch once every C stage is built, report when every
+// stage is done. Returns true if anything changed.
+bool PollPipeline() {
+    if (activePipeline.building) {
+        for (int i = 0; i < activePipeline.stageCount; i++) {
+            Script* script = GetScript(activePipeline.stages[i]);
+            if (script->isCFile && script->compileState == COMPILE_BUSY) {
+                return false;
+            }
+            if (script->isCFile && script->compileState == COMPILE_FAILED) {
+                activePipeline.exitCode = 1;
+                FinishPipeline("a stage failed to compile");
+                return true;
+            }
+        }
+        activePipeline.building = false;
+        if (!LaunchPipeline()) {
+            activePipeline.exitCode = 1;
+            FinishPipeline("the stages could not be started");
+        }
+        return true;
+    }
+    if (!activePipeline.running) {
+        return false;
+    }
+    for (int i = 0; i < activePipeline.stageCount; i++) {
+        // Wait for the consoles too, so the timings come after the output
+        int state = GetProcessState(activePipeline.handles[i], NULL);
+        if (state == PROCESS_QUEUED || state == PROCESS_RUNNING || IsOutputPending(activePipeline.handles[i])) {
+            return false;
+        }
+    }
+    FinishPipeline(NULL);
+    return true;
+}
+
+// Connect the stages with pipes and queue them back to back
+bool LaunchPipeline() {
+#ifdef _WIN32
+    return false;
+#else
+    int count = activePipeline.stageCount;
+    int pipes[MAX_PIPELINE_STAGES][2];
+    for (int i = 0; i < count - 1; i++) {
+        if (OpenPipe(pipes[i]) != 0) {
+            while (i-- > 0) {
+                close(pipes[i][0]);
+                close(pipes[i][1]);
+            }
+            return false;
+        }
+#ifdef F_SETPIPE_SZ
+        // Fewer wakeups when stages pass large amounts of data
+        fcntl(pipes[i][1], F_SETPIPE_SZ, PIPE_BUFFER_BYTES);
+#endif
+    }
+
+    pthread_mutex_lock(&processLock);
+    bool claimed = true;
+    for (int i = 0; i < count; i++) {
+        Script* script = GetScript(activePipeline.stages[i]);
+        const char* argv[] = { PYTHON_PROGRAM, script->filename, NULL };
+        if (script->isCFile) {
+            argv[0] = script->executable;
+            argv[1] = NULL;
+        } else {
+            ExtractPackedFile(script->filename);
+        }
+
+        OutputRing* ring = NULL;
+        if (!activePipeline.headless && activeOutputCount < MAX_ACTIVE_OUTPUTS) {
+            ring = calloc(1, sizeof(OutputRing));
+        }
+        ProcessJob* job = claimed ? ClaimProcessJob(argv, script->number, ring) : NULL;
+        if (!job) {
+            // Unclaimed stages still own their pipe ends
+            free(ring);
+            claimed = false;
+            if (i > 0) {
+                close(pipes[i - 1][0]);
+            }
+            if (i < count - 1) {
+                close(pipes[i][1]);
+            }
+            continue;
+        }
+        job->pipelined = true;
+        job->stdinFd = i > 0 ? pipes[i - 1][0] : -1;
+        job->stdoutFd = i < count - 1 ? pipes[i][1] : -1;
+        activePipeline.handles[i] = job->handle;
+
+        if (!activePipeline.headless) {
+            Console* console = GetConsole(script);
+            char banner[CONSOLE_LINE_LENGTH];
+            snprintf(banner, sizeof(banner), "$ %s   (pipeline stage %d of %d)\n", argv[0], i + 1, count);
+            ConsoleAppend(console, banner, strlen(banner), false);
+            console->scroll = 0;
+            script->runJob = job->handle;
+            if (ring) {
+                activeOutputs[activeOutputCount].ring = ring;
+                activeOutputs[activeOutputCount].scriptNumber = script->number;
+                activeOutputs[activeOutputCount].handle = job->handle;
+                activeOutputCount++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&processLock);
+
+    char wake = 1;
+    ssize_t ignored = write(processWakePipe[1], &wake, 1);
+    (void)ignored;
+    activePipeline.running = true;
+    return claimed;
+#endif
+}
+
+// Report each stage's start and finish relative to the first start, in
+// the last stage's console or, headless, on stderr
+void FinishPipeline(const char* problem) {
+    activePipeline.building = false;
+    activePipeline.running = false;
+    int last = activePipeline.stages[activePipeline.stageCount - 1];
+    Console* console = activePipeline.headless ? NULL : GetConsole(GetScript(last));
+    char line[CONSOLE_LINE_LENGTH];
+
+    if (problem) {
+        snprintf(line, sizeof(line), "[pipeline not run: %s]\n", problem);
+    } else {
+        double origin = 0;
+        for (int i = 0; i < activePipeline.stageCount; i++) {
+            double startedAt = 0;
+            double finishedAt = 0;
+            GetProcessTimes(activePipeline.handles[i], &startedAt, &finishedAt);
+            if (origin == 0 || (startedAt > 0 && startedAt < origin)) {
+                origin = startedAt;
+            }
+        }
+        for (int i = 0; i < activePipeline.stageCount; i++) {
+            double startedAt = 0;
+            double finishedAt = 0;
+            int exitCode = 0;
+            GetProcessTimes(activePipeline.handles[i], &startedAt, &finishedAt);
+            GetProcessState(activePipeline.handles[i], &exitCode);
+            if (exitCode != 0 && activePipeline.exitCode == 0) {
+                activePipeline.exitCode = exitCode;
+            }
+            snprintf(line, sizeof(line), "[stage %d script%d: %.3f s to %.3f s, exit %d]\n", i + 1,
+                    activePipeline.stages[i], startedAt - origin, finishedAt - origin, exitCode);
+            if (console) {
+                ConsoleAppend(console, line, strlen(line), false);
+            } else {
+                fputs(line, stderr);
+            }
+        }
+        snprintf(line, sizeof(line), "[pipeline finished, exit %d]\n", activePipeline.exitCode);
+    }
+    if (console) {
+        ConsoleAppend(console, line, strlen(line), problem != NULL);
+    } else {
+        fputs(line, stderr);
+    }
+}
+
+// --pipeline 3,7,12: run scripts as a pipeline without a window. The last
+// stage writes to stdout, stage timings go to stderr.
+int RunPipelineHeadless(const char* spec) {
+    InitializeAndLoadExistingScripts();
+    StartCompileWorkers();
+    StartProcessPool();
+
+    int stages[MAX_PIPELINE_STAGES];
+    int count = 0;
+    const char* cursor = spec;
+    while (*cursor && count < MAX_PIPELINE_STAGES) {
+        char* end;
+        long number = strtol(cursor, &end, 10);
+        Script* script = number > 0 && number <= MAX_SCRIPT_NUMBER ? FindScript((int)number) : NULL;
+        if (end == cursor || !script || !ScriptFileExists(script) || (*end != ',' && *end != '\0')) {
+            printf("Pipeline stages are existing script numbers, like 3,7,12.\n");
+            return 2;
+        }
+        stages[count++] = (int)number;
+        cursor = *end ? end + 1 : end;
+    }
+
+    if (!StartPipeline(stages, count, true)) {
+        return 2;
+    }
+    while (activePipeline.building || activePipeline.running) {
+        atomic_store(&uiChanged, false);
+        PollCompileJobs();
+        PollPipeline();
+        WaitForActivity(50);
+    }
+    if (lastCompileError[0]) {
+        fprintf(stderr, "%s\n", lastCompileError);
+    }
+    return activePipeline.exitCode;
+}
+
+int CountProcessors() {
+#ifdef _WIN32
+    const char* count = getenv("NUMBER_OF_PROCESSORS");
+    return count ? atoi(count) : 1;
+#else
+    return (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+}
+
+// Wall clock in seconds, usable without a window
+double NowSeconds() {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// stat() and fopen() with a count for the profiler
+int ProfiledStat(const char* path, struct stat* buffer) {
+    atomic_fetch_add(&statCalls, 1);
+    return stat(path, buffer);
+}
+
+FILE* ProfiledFopen(const char* path, const char* mode) {
+    atomic_fetch_add(&fopenCalls, 1);
+    return fopen(path, mode);
+}
+
+int CompareFloats(const void* a, const void* b) {
+    float x = *(const float*)a;
+    float y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Store one drawn frame with the calls and queue depths since the last
+void ProfileFrame(double start, double logicEnd, double drawEnd, double end) {
+    ProfileFrameRecord* frame = &profileFrames[profileFrameCount % PROFILE_FRAMES];
+    frame->start = start;
+    frame->logicMs = (float)((logicEnd - start) * 1000);
+    frame->drawMs = (float)((drawEnd - logicEnd) * 1000);
+    frame->frameMs = (float)((end - start) * 1000);
+    frame->stats = (uint16_t)atomic_exchange(&statCalls, 0);
+    frame->opens = (uint16_t)atomic_exchange(&fopenCalls, 0);
+    frame->spawns = (uint16_t)atomic_exchange(&spawnCalls, 0);
+
+    pthread_mutex_lock(&compileLock);
+    frame->compileQueue = (uint16_t)pendingCompileCount;
+    frame->compileBusy = (uint16_t)busyCompileWorkers;
+    pthread_mutex_unlock(&compileLock);
+
+    int queued = 0;
+    int running = 0;
+    pthread_mutex_lock(&processLock);
+    for (int i = 0; i < MAX_PROCESS_JOBS; i++) {
+        queued += processJobs[i].state == PROCESS_QUEUED;
+        running += processJobs[i].state == PROCESS_RUNNING;
+    }
+    pthread_mutex_unlock(&processLock);
+    frame->runQueue = (uint16_t)queued;
+    frame->running = (uint16_t)running;
+    profileFrameCount++;
+}
+
+// Called from the compile workers and the reapers
+void ProfileSpan(int scriptNumber, bool compile, double start, double end) {
+    pthread_mutex_lock(&profileLock);
+    ProfileSpanRecord* span = &profileSpans[profileSpanCount % PROFILE_SPANS];
+    span->start = start;
+    span->end = end;
+    span->scriptNumber = scriptNumber;
+    span->compile = compile;
+    profileSpanCount++;
+    pthread_mutex_unlock(&profileLock);
+}
+
+// Overlay in the top right corner: frame times of the kept frames with
+// their p50 and p99, and the newest frame's split, calls and queues
+void DrawProfilerHud(int screenWidth) {
+    int count = profileFrameCount < PROFILE_FRAMES ? profileFrameCount : PROFILE_FRAMES;
+    if (count == 0) {
+        return;
+    }
+    static float sorted[PROFILE_FRAMES];
+    float logicMs = 0;
+    float drawMs = 0;
+    for (int i = 0; i < count; i++) {
+        sorted[i] = profileFrames[i].frameMs;
+        logicMs += profileFrames[i].logicMs;
+        drawMs += profileFrames[i].drawMs;
+    }
+    qsort(sorted, count, sizeof(float), CompareFloats);
+    float p50 = sorted[count / 2];
+    float p99 = sorted[count * 99 / 100];
+    const ProfileFrameRecord* last = &profileFrames[(profileFrameCount - 1) % PROFILE_FRAMES];
+
+    int width = 330;
+    int x = screenWidth - width - 10;
+    int y = 40;
+    DrawRectangle(x, y, width, 250, Fade(BLACK, 0.75f));
+
+    // Newest frames on the right, 1 px per ms up to 50 ms; the line is 60 fps
+    int graphHeight = 60;
+    int bars = count < width - 20 ? count : width - 20;
+    for (int i = 0; i < bars; i++) {
+        const ProfileFrameRecord* frame = &profileFrames[(profileFrameCount - bars + i) % PROFILE_FRAMES];
+        int height = (int)fminf(frame->frameMs * graphHeight / 50.0f, (float)graphHeight);
+        Color color = frame->frameMs > 33.4f ? RED : (frame->frameMs > 16.7f ? ORANGE : GREEN);
+        DrawRectangle(x + 10 + i, y + 10 + graphHeight - height, 1, height, color);
+    }
+    DrawLine(x + 10, y + 10 + graphHeight - graphHeight * 16.7f / 50, x + width - 10,
+            y + 10 + graphHeight - graphHeight * 16.7f / 50, Fade(WHITE, 0.5f));
+
+    int textY = y + graphHeight + 20;
+    DrawText(TextFormat("frame p50 %.1f ms  p99 %.1f ms  (%d)", p50, p99, count), x + 10, textY, 18, WHITE);
+    DrawText(TextFormat("logic %.2f ms  draw %.2f ms (mean)", logicMs / count, drawMs / count), x + 10, textY + 22, 18, WHITE);
+    DrawText(TextFormat("last: logic %.2f  draw %.2f  frame %.1f", last->logicMs, last->drawMs, last->frameMs),
+            x + 10, textY + 44, 18, WHITE);
+    DrawText(TextFormat("calls/frame: stat %d  fopen %d  spawn %d", last->stats, last->opens, last->spawns),
+            x + 10, textY + 66, 18, WHITE);
+    DrawText(TextFormat("compile: %d queued, %d/%d busy", last->compileQueue, last->compileBusy, compileWorkers),
+            x + 10, textY + 88, 18, WHITE);
+    DrawText(TextFormat("run: %d queued, %d running (-j %d)", last->runQueue, last->running, maxRunningProcesses),
+            x + 10, textY + 110, 18, WHITE);
+    DrawText("[F3] hide  [F4] save " PROFILE_TRACE_PATH, x + 10, textY + 136, 18, LIGHTGRAY);
+}
+
+// Chrome trace (chrome://tracing, Perfetto) of the last seconds: frames
+// with their logic and draw phases, per-frame counters, and a row per
+// script for its compiles and runs
+bool WriteProfileTrace(const char* path, double seconds) {
+    FILE* file = ProfiledFopen(path, "w");
+    if (!file) {
+        return false;
+    }
+    double since = NowSeconds() - seconds;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"frame loop\"}},\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"scripts\"}}");
+
+    int count = profileFrameCount < PROFILE_FRAMES ? profileFrameCount : PROFILE_FRAMES;
+    for (int i = 0; i < count; i++) {
+        const ProfileFrameRecord* frame = &profileFrames[(profileFrameCount - count + i) % PROFILE_FRAMES];
+        if (frame->start < since) {
+            continue;
+        }
+        double ts = frame->start * 1e6;
+        fprintf(file, ",\n{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.0f,\"dur\":%.0f}",
+                ts, frame->frameMs * 1e3);
+        fprintf(file, ",\n{\"name\":\"logic\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.0f,\"dur\":%.0f}",
+                ts, frame->logicMs * 1e3);
+        fprintf(file, ",\n{\"name\":\"draw\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.0f,\"dur\":%.0f}",
+                ts + frame->logicMs * 1e3, frame->drawMs * 1e3);
+        fprintf(file, ",\n{\"name\":\"calls\",\"ph\":\"C\",\"pid\":1,\"ts\":%.0f,"
+                "\"args\":{\"stat\":%d,\"fopen\":%d,\"spawn\":%d}}", ts, frame->stats, frame->opens, frame->spawns);
+        fprintf(file, ",\n{\"name\":\"queues\",\"ph\":\"C\",\"pid\":1,\"ts\":%.0f,"
+                "\"args\":{\"compile queued\":%d,\"compiling\":%d,\"run queued\":%d,\"running\":%d}}",
+                ts, frame->compileQueue, frame->compileBusy, frame->runQueue, frame->running);
+    }
+
+    pthread_mutex_lock(&profileLock);
+    count = profileSpanCount < PROFILE_SPANS ? profileSpanCount : PROFILE_SPANS;
+    for (int i = 0; i < count; i++) {
+        const ProfileSpanRecord* span = &profileSpans[(profileSpanCount - count + i) % PROFILE_SPANS];
+        if (span->end < since) {
+            continue;
+        }
+        fprintf(file, ",\n{\"name\":\"%s %d\",\"ph\":\"X\",\"pid\":2,\"tid\":%d,\"ts\":%.0f,\"dur\":%.0f}",
+                span->compile ? "compile" : "run", span->scriptNumber, span->scriptNumber,
+                span->start * 1e6, (span->end - span->start) * 1e6);
+    }
+    pthread_mutex_unlock(&profileLock);
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+// 64-bit FNV-1a
+unsigned long long HashBytes(unsigned long long hash, const void* data, size_t length) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Hash a source file and, recursively, every header it pulls in with
+// #include "..." (resolved next to the including file). System headers
+// are covered by the compiler name in the key.
+unsigned long long HashSourceTree(unsigned long long hash, const char* path, int depth) {
+    hash = HashBytes(hash, path, strlen(path) + 1);
+
+    FILE* file = ProfiledFopen(path, "rb");
+    if (!file || depth > MAX_INCLUDE_DEPTH) {
+        if (file) {
+            fclose(file);
+        }
+        return HashBytes(hash, "?", 1);  // missing header still changes the key
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = malloc(size + 1);
+    size_t length = fread(text, 1, size, file);
+    text[length] = '\0';
+    fclose(file);
+
+    // Directory of this file, for resolving quoted includes
+    char directory[256] = "";
+    const char* slash = strrchr(path, '/');
+    if (slash && (size_t)(slash - path + 1) < sizeof(directory)) {
+        memcpy(directory, path, slash - path + 1);
+        directory[slash - path + 1] = '\0';
+    }
+    hash = HashSourceText(hash, directory, text, length, depth);
+    free(text);
+    return hash;
+}
+
+// Hash source text and the local headers it includes from directory.
+// Also used for encoded scripts, whose text never exists as a file.
+unsigned long long HashSourceText(unsigned long long hash, const char* directory, char* text, size_t length, int depth) {
+    hash = HashBytes(hash, text, length);
+    for (char* line = text; line && *line; ) {
+        char* next = strchr(line, '\n');
+        while (*line == ' ' || *line == '\t') {
+            line++;
+        }
+        if (*line == '#') {
+            line++;
+            while (*line == ' ' || *line == '\t') {
+                line++;
+            }
+            if (strncmp(line, "include", 7) == 0) {
+                char* open = strchr(line + 7, '"');
+                char* close = open ? strchr(open + 1, '"') : NULL;
+                if (close && (!next || close < next)) {
+                    char header[512];
+                    snprintf(header, sizeof(header), "%s%.*s", directory, (int)(close - open - 1), open + 1);
+                    hash = HashSourceTree(hash, header, depth + 1);
+                }
+            }
+        }
+        line = next ? next + 1 : NULL;
+    }
+    return hash;
+}
+
+// Run a shell command with input as its stdin, collecting what it prints
+// (stdout and stderr if the command redirects it) into output. Returns
+// the wait status like pclose(), or -1 if it could not start.
+int RunWithInput(const char* command, const char* input, size_t length, char* output, size_t size) {
+    output[0] = '\0';
+#ifdef _WIN32
+    // _popen is one-way: the input goes in, output goes to the terminal
+    FILE* pipe = _popen(command, "wb");
+    if (!pipe) {
+        return -1;
+    }
+    fwrite(input, 1, length, pipe);
+    snprintf(output, size, "(compiler output is in the terminal)\n");
+    return _pclose(pipe);
+#else
+    int in[2];
+    int out[2];
+    if (OpenPipe(in) != 0) {
+        return -1;
+    }
+    if (OpenPipe(out) != 0) {
+        close(in[0]);
+        close(in[1]);
+        return -1;
+    }
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, in[0], 0);
+    posix_spawn_file_actions_adddup2(&actions, out[1], 1);
+    const char* argv[] = { "sh", "-c", command, NULL };
+    extern char** environ;
+    pid_t pid;
+    atomic_fetch_add(&spawnCalls, 1);
+    int result = posix_spawnp(&pid, "sh", &actions, NULL, (char* const*)argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(in[0]);
+    close(out[1]);
+    if (result != 0) {
+        close(in[1]);
+        close(out[0]);
+        return -1;
+    }
+
+    // Feed and drain together so neither side can fill its pipe and stall
+    fcntl(in[1], F_SETFL, O_NONBLOCK);
+    size_t written = 0;
+    size_t used = 0;
+    if (length == 0) {
+        close(in[1]);
+        in[1] = -1;
+    }
+    while (1) {
+        struct pollfd fds[2] = { { out[0], POLLIN, 0 }, { in[1], POLLOUT, 0 } };
+        if (poll(fds, in[1] >= 0 ? 2 : 1, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        if (in[1] >= 0 && (fds[1].revents & (POLLOUT | POLLERR | POLLHUP))) {
+            ssize_t count = write(in[1], input + written, length - written);
+            if (count > 0) {
+                written += count;
+            }
+            if ((count < 0 && errno != EAGAIN && errno != EINTR) || written == length) {
+                close(in[1]);
+                in[1] = -1;
+            }
+        }
+        if (fds[0].revents & (POLLIN | POLLHUP | POLLERR)) {
+            char chunk[1024];
+            ssize_t count = read(out[0], chunk, sizeof(chunk));
+            if (count <= 0) {
+                break;
+            }
+            // Keep the start, drop what does not fit
+            size_t keep = used + 1 < size ? size - used - 1 : 0;
+            keep = keep < (size_t)count ? keep : (size_t)count;
+            memcpy(output + used, chunk, keep);
+            used += keep;
+            output[used] = '\0';
+        }
+    }
+    if (in[1] >= 0) {
+        close(in[1]);
+    }
+    close(out[0]);
+    int status;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {
+    }
+    return status;
+#endif
+}
+
+void StartCompileWorkers() {
+    compileWorkers = CountProcessors();
+    if (compileWorkers < 1) {
+        compileWorkers = 1;
+    } else if (compileWorkers > MAX_COMPILE_WORKERS) {
+        compileWorkers = MAX_COMPILE_WORKERS;
+    }
+    for (int i = 0; i < compileWorkers; i++) {
+        pthread_t thread;
+        pthread_create(&thread, NULL, CompileWorkerThread, NULL);
+        pthread_detach(thread);
+    }
+}
+
+void* CompileWorkerThread(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&compileLock);
+        while (pendingHead == NULL) {
+            pthread_cond_wait(&compileReady, &compileLock);
+        }
+        CompileJob* job = pendingHead;
+        pendingHead = job->next;
+        if (pendingHead == NULL) {
+            pendingTail = NULL;
+        }
+        job->next = NULL;
+        pendingCompileCount--;
+        busyCompileWorkers++;
+        pthread_mutex_unlock(&compileLock);
+        job->startedAt = NowSeconds();
+
+        // Cache key: compiler, flags, the source and its local headers.
+        // An unchanged script reuses its executable without running gcc.
+        unsigned long long key = HashBytes(14695981039346656037ULL, C_COMPILER " " C_FLAGS, strlen(C_COMPILER " " C_FLAGS));
+        if (job->input) {
+            key = HashBytes(key, job->source, strlen(job->source) + 1);
+            key = HashSourceText(key, GAME_FILES_PATH, job->input, job->inputLength, 0);
+        } else {
+            key = HashSourceTree(key, job->source, 0);
+        }
+        snprintf(job->output, sizeof(job->output), BUILD_CACHE_PATH "%016llx.exe", key);
+
+        char temporary[128];
+        snprintf(temporary, sizeof(temporary), BUILD_CACHE_PATH "%016llx.%d.tmp", key, job->scriptNumber);
+
+        char command[512];
+        snprintf(command, sizeof(command), C_COMPILER " " C_FLAGS " %s -o %s 2>&1", job->source, temporary);
+
+        if (DoesFileExist(job->output)) {
+            job->cached = true;
+            job->exitCode = 0;
+            utime(job->output, NULL);  // mtime orders the cache for PruneBuildCache
+        } else if (job->input) {
+            // Encoded script: gcc reads the decoded text from stdin, and
+            // quoted includes resolve from gameFiles/ as they would for
+            // the loose file
+            snprintf(command, sizeof(command), C_COMPILER " " C_FLAGS " -x c - -I" GAME_FILES_PATH " -o %s 2>&1", temporary);
+            job->exitCode = RunWithInput(command, job->input, job->inputLength, job->errors, COMPILE_ERROR_LENGTH);
+            if (job->exitCode == -1) {
+                snprintf(job->errors, COMPILE_ERROR_LENGTH, "Could not start gcc.\n");
+            } else if (job->exitCode == 0 && rename(temporary, job->output) != 0) {
+                remove(temporary);
+            }
+        } else {
+            // Capture this job's compiler output through its own pipe
+            atomic_fetch_add(&spawnCalls, 1);
+            FILE* pipe = popen(command, "r");
+            if (pipe) {
+                size_t length = fread(job->errors, 1, COMPILE_ERROR_LENGTH - 1, pipe);
+                job->errors[length] = '\0';
+                // Drain anything past the capture limit so gcc doesn't block
+                char discard[256];
+                while (fread(discard, 1, sizeof(discard), pipe) > 0) {
+                }
+                job->exitCode = pclose(pipe);
+
+                // Publish the build under its key; a concurrent build of the
+                // same content may already have done so
+                if (job->exitCode == 0 && rename(temporary, job->output) != 0) {
+                    remove(temporary);
+                }
+            } else {
+                snprintf(job->errors, COMPILE_ERROR_LENGTH, "Could not start gcc.\n");
+                job->exitCode = -1;
+            }
+        }
+        free(job->input);
+        job->input = NULL;
+        job->seconds = NowSeconds() - job->startedAt;
+        ProfileSpan(job->scriptNumber, true, job->startedAt, job->startedAt + job->seconds);
+
+        pthread_mutex_lock(&compileLock);
+        busyCompileWorkers--;
+        job->next = completedJobs;
+        completedJobs = job;
+        pthread_mutex_unlock(&compileLock);
+        WakeFrameLoop();
+    }
+    return NULL;
+}
+
+typedef struct {
+    char name[64];
+    long long size;
+    time_t mtime;
+} BuildCacheEntry;
+
+int CompareBuildCacheEntries(const void* a, const void* b) {
+    const BuildCacheEntry* x = (const BuildCacheEntry*)a;
+    const BuildCacheEntry* y = (const BuildCacheEntry*)b;
+    return x->mtime < y->mtime ? -1 : (x->mtime > y->mtime ? 1 : 0);
+}
+
+// Keep the build cache under BUILD_CACHE_BYTES. Builds are only ever
+// reclaimed here, at startup, least recently used first, so switching a
+// script back to earlier content still finds its build. Temporaries from
+// compiles that never finished go too.
+void PruneBuildCache() {
+    DIR* dir = opendir(BUILD_CACHE_PATH);
+    if (!dir) {
+        return;
+    }
+    int capacity = 64;
+    int count = 0;
+    long long total = 0;
+    BuildCacheEntry* entries = malloc(capacity * sizeof(BuildCacheEntry));
+    struct dirent* item;
+    while ((item = readdir(dir)) != NULL) {
+        char path[sizeof(BUILD_CACHE_PATH) + sizeof(item->d_name)];
+        struct stat buffer;
+        size_t length = strlen(item->d_name);
+        if (length >= sizeof(entries[0].name)) {
+            continue;
+        }
+        snprintf(path, sizeof(path), BUILD_CACHE_PATH "%s", item->d_name);
+        if (length > 4 && strcmp(item->d_name + length - 4, ".tmp") == 0) {
+            remove(path);
+            continue;
+        }
+        if (length <= 4 || strcmp(item->d_name + length - 4, ".exe") != 0 || ProfiledStat(path, &buffer) != 0) {
+            continue;
+        }
+        if (count == capacity) {
+            capacity *= 2;
+            entries = realloc(entries, capacity * sizeof(BuildCacheEntry));
+        }
+        memcpy(entries[count].name, item->d_name, length + 1);
+        entries[count].size = (long long)buffer.st_size;
+        entries[count].mtime = buffer.st_mtime;
+        total += entries[count].size;
+        count++;
+    }
+    closedir(dir);
+
+    qsort(entries, count, sizeof(BuildCacheEntry), CompareBuildCacheEntries);
+    for (int i = 0; i < count && total > BUILD_CACHE_BYTES; i++) {
+        char path[sizeof(BUILD_CACHE_PATH) + sizeof(entries[i].name)];
+        snprintf(path, sizeof(path), BUILD_CACHE_PATH "%s", entries[i].name);
+        if (remove(path) == 0) {
+            total -= entries[i].size;
+        }
+    }
+    free(entries);
+}
+
+// Deliver finished compiles to the frame loop: run successful builds
+// (unless they belong to a build-all batch) and report failures. Returns
+// true if any were delivered.
+bool PollCompileJobs() {
+    pthread_mutex_lock(&compileLock);
+    CompileJob* job = completedJobs;
+    completedJobs = NULL;
+    pthread_mutex_unlock(&compileLock);
+    bool changed = job != NULL;
+
+    while (job) {
+        CompileJob* next = job->next;
+        Script* script = GetScript(job->scriptNumber);
+        script->buildSeconds = (float)job->seconds;
+
+        // Compiler output goes to the script's console, warnings included
+        Console* console = GetConsole(script);
+        if (job->cached) {
+            const char* message = "[unchanged, using cached build]\n";
+            ConsoleAppend(console, message, strlen(message), false);
+        } else {
+            char message[64];
+            snprintf(message, sizeof(message), "[compiled in %.2f s]\n", job->seconds);
+            ConsoleAppend(console, message, strlen(message), false);
+        }
+        ConsoleAppend(console, job->errors, strlen(job->errors), true);
+
+        if (job->exitCode == 0) {
+            script->compileState = COMPILE_OK;
+            snprintf(script->executable, sizeof(script->executable), "%s", job->output);
+            if (!job->buildOnly) {
+                const char* argv[] = { job->output, NULL };
+                RunScriptProcess(argv, job->scriptNumber);
+            }
+        } else {
+            script->compileState = COMPILE_FAILED;
+
+            // Keep the first error line for the feedback panel
+            const char* line = job->errors;
+            const char* error = strstr(job->errors, "error");
+            if (error) {
+                while (error > job->errors && error[-1] != '\n') {
+                    error--;
+                }
+                line = error;
+            }
+            size_t lineLength = strcspn(line, "\n");
+            if (lineLength >= sizeof(lastCompileError)) {
+                lineLength = sizeof(lastCompileError) - 1;
+            }
+            memcpy(lastCompileError, line, lineLength);
+            lastCompileError[lineLength] = '\0';
+            lastCompileErrorScript = job->scriptNumber;
+            const char* message = "Compilation failed.\n";
+            ConsoleAppend(console, message, strlen(message), true);
+            console->scroll = 0;
+        }
+
+        if (job->batch && buildBatchActive) {
+            BuildResult* result = &buildResults[buildResultCount++];
+            result->scriptNumber = job->scriptNumber;
+            result->exitCode = job->exitCode;
+            result->cached = job->cached;
+            result->seconds = job->seconds;
+            snprintf(result->error, sizeof(result->error), "%s", job->exitCode != 0 ? lastCompileError : "");
+            buildBatchFailed += job->exitCode != 0;
+            buildBatchUpToDate += job->exitCode == 0 && job->cached;
+            if (buildResultCount == buildBatchTotal) {
+                FinishBuildReport();
+            }
+        }
+
+        free(job);
+        job = next;
+    }
+    return changed;
+}
+
+void CreateNewScript(int gridIndex, int scriptIndex) {
+    Script* script = GetGridScript(gridIndex, scriptIndex);
+    selectedScriptIndex = scriptIndex;
+    script->isEditing = true;
+
+    pthread_mutex_lock(&scriptTextLock);
+    if (isCFile) {
+        snprintf(script->filename, sizeof(script->filename), GAME_FILES_PATH "script%d.c", script->number);
+    } else {
+        snprintf(script->filename, sizeof(script->filename), GAME_FILES_PATH "script%d.py", script->number);
+    }
+    script->isCFile = isCFile;
+    pthread_mutex_unlock(&scriptTextLock);
+
+    if (!ScriptFileExists(script)) {
+        // Initialize with appropriate template based on file type
+        if (isCFile) {
+            SaveScriptToFile(script->filename, 
+                "#include <stdio.h>\n\nint main() {\n    printf(\"Hello, World!\\n\");\n    return 0;\n}\n");
+        } else {
+            SaveScriptToFile(script->filename, 
+                "# Python Script Template\nprint(\"Hello, World!\")\n");
+        }
+    }
+    
+    // Load the script content into memory
+    LoadScriptText(script);
+    
+    // Open the script in the editor
+    OpenEditor(script->filename, script->number);
+}
+
+// Background, border, type and name of one grid button. Labels are
+// dropped once the cell gets too small to read them.
+void DrawScriptButton(int index, bool selected) {
+    Script* script = FindScript(currentGridIndex * scriptsPerGrid + index + 1);
+    bool exists = script && ScriptFileExists(script);
+    Rectangle button = CellRect(index);
+    float cell = button.width;
+
+    // Default button color is light gray
+    Color buttonColor = LIGHTGRAY; 
+    Color textColor = DARKGRAY;
+
+    // Determine button color based on script status
+    if (exists) {
+        if (script->isCFile) {
+            buttonColor = YELLOW;  // Yellow for C scripts
+        } else {
+            buttonColor = PURPLE;  // Purple for Python scripts
+        }
+        
+        // Add different shade for currently selected script
+        if (selected) {
+            buttonColor = ColorBrightness(buttonColor, 0.7f);  // Brighten the color
+            textColor = BLACK;  // Make text more visible
+        }
+    } else if (selected) {
+        buttonColor = ORANGE;  // Orange for selected but non-existent script
+    }
+
+    // Draw button with the determined color
+    DrawRectangleRec(button, buttonColor);
+
+    // Recent run times along the bottom edge, coloured by duration; cells
+    // too small for bars get a stripe in the colour of the last run
+    float runs[RUN_HISTORY_LENGTH];
+    int runCount = 0;
+    if (script) {
+        pthread_mutex_lock(&historyLock);
+        runCount = script->recentRunCount;
+        memcpy(runs, script->recentRuns, runCount * sizeof(float));
+        pthread_mutex_unlock(&historyLock);
+    }
+    if (runCount > 0 && cell < 30) {
+        DrawRectangle(button.x, button.y + cell * 3 / 4, cell, cell / 4 + 1, HeatColor(runs[runCount - 1]));
+    } else if (runCount > 0) {
+        float slowest = 0.001f;
+        for (int i = 0; i < runCount; i++) {
+            slowest = fmaxf(slowest, runs[i]);
+        }
+        float barWidth = (cell - 10 * zoom) / RUN_HISTORY_LENGTH;
+        float height = 10 * zoom;
+        for (int i = 0; i < runCount; i++) {
+            float bar = fmaxf(1, height * runs[i] / slowest);
+            DrawRectangle(button.x + 5 * zoom + i * barWidth, button.y + cell - 2 * zoom - bar,
+                    fmaxf(1, barWidth - 1), bar, HeatColor(runs[i]));
+        }
+    }
+
+    DrawRectangleLinesEx(button, cell >= 20 ? 2 : 1, DARKGRAY);
+    if (cell < 30) {
+        return;
+    }
+
+    // Draw script indicator
+    int large = (int)(20 * zoom);
+    int small = (int)(16 * zoom);
+    if (exists) {
+        DrawText(script->isCFile ? "C" : "P", button.x + cell - 20 * zoom, button.y + 5 * zoom, large, textColor);
+    }
+    
+    // Draw script number
+    DrawText(TextFormat("%d", currentGridIndex * scriptsPerGrid + index + 1), button.x + 5 * zoom, button.y + 5 * zoom, large, textColor);
+    if (cell < 60) {
+        return;
+    }
+    
+    // Draw script name or status
+    if (selected && script && script->isEditing) {
+        DrawText("Editing...", button.x + 5 * zoom, button.y + cell - 25 * zoom, large, textColor);
+    } else if (exists) {
+        // Show abbreviated filename (just the number part)
+        char* lastSlash = strrchr(script->filename, '/');
+        DrawText(lastSlash ? lastSlash + 1 : script->filename, button.x + 5 * zoom, button.y + cell - 25 * zoom, small, textColor);
+    }
+}
+
+// Run and compile state drawn over a button every frame
+void DrawScriptStatus(int index) {
+    Script* script = FindScript(currentGridIndex * scriptsPerGrid + index + 1);
+    if (!script || (!script->runJob && script->compileState == COMPILE_IDLE)) {
+        return;
+    }
+    Rectangle button = CellRect(index);
+    Color textColor = (index == selectedScriptIndex && ScriptFileExists(script)) ? BLACK : DARKGRAY;
+    int fontSize = (int)(16 * zoom);
+    bool labels = button.width >= 60;
+
+    // Draw run status of the script's last process
+    int exitCode = 0;
+    int runState = script->runJob ? GetProcessState(script->runJob, &exitCode) : PROCESS_FREE;
+    if (!labels) {
+        // Too small for text: running scripts get a dot instead
+        if (runState == PROCESS_QUEUED || runState == PROCESS_RUNNING) {
+            DrawRectangle(button.x + 2, button.y + 2, button.width / 4 + 1, button.height / 4 + 1, BLUE);
+        }
+    } else if (runState == PROCESS_QUEUED) {
+        DrawText("Queued", button.x + 5 * zoom, button.y + 58 * zoom, fontSize, textColor);
+    } else if (runState == PROCESS_RUNNING) {
+        DrawText("Running...", button.x + 5 * zoom, button.y + 58 * zoom, fontSize, textColor);
+    } else if (runState == PROCESS_DONE && exitCode != 0) {
+        DrawText(TextFormat("Exit %d", exitCode), button.x + 5 * zoom, button.y + 58 * zoom, fontSize, RED);
+    }
+
+    // Draw compile status for C scripts
+    float border = button.width >= 20 ? 4 : 1;
+    if (script->compileState == COMPILE_BUSY) {
+        if (labels) {
+            DrawText("Compiling...", button.x + 5 * zoom, button.y + 40 * zoom, fontSize, textColor);
+        }
+    } else if (script->compileState == COMPILE_OK) {
+        DrawRectangleLinesEx(button, border, DARKGREEN);
+        if (labels) {
+            DrawText("Build OK", button.x + 5 * zoom, button.y + 40 * zoom, fontSize, DARKGREEN);
+        }
+    } else if (script->compileState == COMPILE_FAILED) {
+        DrawRectangleLinesEx(button, border, RED);
+        if (labels) {
+            DrawText("Build failed", button.x + 5 * zoom, button.y + 40 * zoom, fontSize, RED);
+        }
+    }
+}
+
+// Fit the view to the window, ease the scroll toward its target and keep
+// it inside the grid. Returns true while the view is still moving.
+bool UpdateGridView(int screenWidth, int screenHeight) {
+    float cell = BUTTON_SIZE * zoom;
+    float gridWidth = gridCols * cell;
+    float gridHeight = gridRows * cell;
+    gridView.x = 0;
+    gridView.y = 0;
+    gridView.width = fminf(gridWidth, fmaxf(BUTTON_SIZE, screenWidth - PANEL_WIDTH));
+    gridView.height = fminf(gridHeight, fmaxf(BUTTON_SIZE, screenHeight - 40 - CONSOLE_HEIGHT));
+
+    targetScroll.x = fmaxf(0, fminf(targetScroll.x, gridWidth - gridView.width));
+    targetScroll.y = fmaxf(0, fminf(targetScroll.y, gridHeight - gridView.height));
+    float step = fminf(1.0f, SCROLL_SPEED * GetFrameTime());
+    scroll.x = fmaxf(0, fminf(scroll.x + (targetScroll.x - scroll.x) * step, gridWidth - gridView.width));
+    scroll.y = fmaxf(0, fminf(scroll.y + (targetScroll.y - scroll.y) * step, gridHeight - gridView.height));
+    if (fabsf(targetScroll.x - scroll.x) < 0.5f && fabsf(targetScroll.y - scroll.y) < 0.5f) {
+        scroll = targetScroll;
+        return false;
+    }
+    return true;
+}
+
+// Zoom by factor, keeping the grid point under anchor where it is
+void ZoomGridView(float factor, Vector2 anchor) {
+    float newZoom = fmaxf(MIN_ZOOM, fminf(MAX_ZOOM, zoom * factor));
+    float ratio = newZoom / zoom;
+    float offsetX = anchor.x - gridView.x;
+    float offsetY = anchor.y - gridView.y;
+    targetScroll.x = (scroll.x + offsetX) * ratio - offsetX;
+    targetScroll.y = (scroll.y + offsetY) * ratio - offsetY;
+    scroll = targetScroll;
+    zoom = newZoom;
+}
+
+// Column and row range inside gridView, inclusive
+void GetVisibleCells(int* firstCol, int* lastCol, int* firstRow, int* lastRow) {
+    float cell = BUTTON_SIZE * zoom;
+    *firstCol = (int)(scroll.x / cell);
+    *firstRow = (int)(scroll.y / cell);
+    *lastCol = (int)((scroll.x + gridView.width - 1) / cell);
+    *lastRow = (int)((scroll.y + gridView.height - 1) / cell);
+    if (*lastCol >= gridCols) {
+        *lastCol = gridCols - 1;
+    }
+    if (*lastRow >= gridRows) {
+        *lastRow = gridRows - 1;
+    }
+}
+
+// The cell under a screen point, or -1. The grid is uniform, so this is a
+// direct lookup rather than a test against every button.
+int CellAt(Vector2 point) {
+    if (!CheckCollisionPointRec(point, gridView)) {
+        return -1;
+    }
+    float cell = BUTTON_SIZE * zoom;
+    int col = (int)((point.x - gridView.x + scroll.x) / cell);
+    int row = (int)((point.y - gridView.y + scroll.y) / cell);
+    if (col < 0 || col >= gridCols || row < 0 || row >= gridRows) {
+        return -1;
+    }
+    return row * gridCols + col;
+}
+
+// Screen rectangle of a cell at the current scroll and zoom
+Rectangle CellRect(int index) {
+    float cell = BUTTON_SIZE * zoom;
+    Rectangle rect = { gridView.x + (index % gridCols) * cell - scroll.x, gridView.y + (index / gridCols) * cell - scroll.y, cell, cell };
+    return rect;
+}
+
+// Everything the cached grid layer depends on: the view, the visible cells
+// and the run history drawn on them
+unsigned long long GridSignature(int gridIndex) {
+    unsigned long long hash = HashBytes(14695981039346656037ULL, &gridIndex, sizeof(gridIndex));
+    unsigned int version = atomic_load(&runHistoryVersion);
+    hash = HashBytes(hash, &version, sizeof(version));
+    hash = HashBytes(hash, &gridView, sizeof(gridView));
+    hash = HashBytes(hash, &scroll, sizeof(scroll));
+    hash = HashBytes(hash, &zoom, sizeof(zoom));
+
+    int firstCol, lastCol, firstRow, lastRow;
+    GetVisibleCells(&firstCol, &lastCol, &firstRow, &lastRow);
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            Script* script = FindScript(gridIndex * scriptsPerGrid + row * gridCols + col + 1);
+            if (script) {
+                hash = HashBytes(hash, &script->number, sizeof(script->number));
+                hash = HashBytes(hash, &script->status.flags, sizeof(script->status.flags));
+                hash = HashBytes(hash, &script->isCFile, sizeof(script->isCFile));
+                hash = HashBytes(hash, script->filename, strlen(script->filename));
+            }
+        }
+    }
+    return hash;
+}
+
+// Draw the unselected visible buttons, re-rendering the cached layer first
+// if the view or the visible cells' files changed since it was last built
+void DrawGridLayer() {
+    if (gridTextureReady && (gridTexture.texture.width != (int)gridView.width || gridTexture.texture.height != (int)gridView.height)) {
+        UnloadRenderTexture(gridTexture);
+        gridTextureReady = false;
+    }
+    if (!gridTextureReady) {
+        gridTexture = LoadRenderTexture((int)gridView.width, (int)gridView.height);
+        gridTextureReady = true;
+        gridTextureSignature = ~GridSignature(currentGridIndex);
+    }
+
+    unsigned long long signature = GridSignature(currentGridIndex);
+    if (signature != gridTextureSignature) {
+        gridTextureSignature = signature;
+        BeginTextureMode(gridTexture);
+        ClearBackground(RAYWHITE);
+        int firstCol, lastCol, firstRow, lastRow;
+        GetVisibleCells(&firstCol, &lastCol, &firstRow, &lastRow);
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int col = firstCol; col <= lastCol; col++) {
+                DrawScriptButton(row * gridCols + col, false);
+            }
+        }
+        EndTextureMode();
+    }
+
+    // Render textures are stored bottom-up, hence the negative height
+    Rectangle source = { 0, 0, gridTexture.texture.width, -gridTexture.texture.height };
+    DrawTextureRec(gridTexture.texture, source, (Vector2){ gridView.x, gridView.y }, WHITE);
+}
+
+void CreateDescriptionFile(const char* scriptFilename) {
+    char descriptionFilename[256];
+    snprintf(descriptionFilename, sizeof(descriptionFilename), "%s_description.txt", scriptFilename);
+    ExtractPackedFile(descriptionFilename);
+
+    if (!DoesFileExist(descriptionFilename)) {
+        FILE* file = ProfiledFopen(descriptionFilename, "w");
+        if (file) {
+            fprintf(file, "Description for %s\n\nEnter your description here.\n", scriptFilename);
+            fclose(file);
+        }
+    }
+    
+    // Open the description file in the editor
+    OpenEditor(descriptionFilename, 0);
+}
+
+void SwitchGrid(int gridID) {
+    if (gridID >= 0 && gridID < gridCount) {
+        currentGridIndex = gridID;
+        selectedScriptIndex = -1;
+        RequestGridLoad(gridID);
+    }
+}
+
+void ToggleScriptMode() {
+    // Toggle between Python mode and C mode
+    isCFile = !isCFile;
+    
+    // Reset the selected script index when changing modes
+    selectedScriptIndex = -1;
+}
+
+void ToggleEditMode() {
+    isEditingMode = !isEditingMode;
+}
+
+void DrawHelpMenu() {
+    int helpX = 20;
+    int helpY = 100;
+    DrawRectangle(10, 90, 780, 610, LIGHTGRAY);
+    DrawText("HELP MENU", helpX, helpY, 30, DARKGRAY);
+    DrawText("1. Grid Navigation: Use LEFT and RIGHT arrow keys to switch grids.", helpX, helpY + 40, 20, DARKGRAY);
+    DrawText("2. Python/C Mode Toggle: Press '1' to switch between Python and C modes.", helpX, helpY + 70, 20, DARKGRAY);
+    DrawText("3. Edit/Execute Mode Toggle: Press '2' to toggle between Editing and Executing modes.", helpX, helpY + 100, 20, DARKGRAY);
+    DrawText("4. Creating Scripts: Click on a grid button to create a new script in the selected mode.", helpX, helpY + 130, 20, DARKGRAY);
+    DrawText("5. Editing Scripts: Click an existing script to edit it here (Shift+click for Notepad).", helpX, helpY + 160, 20, DARKGRAY);
+    DrawText("6. Saving Scripts: Press Ctrl+S in the editor to save, Esc to close it.", helpX, helpY + 190, 20, DARKGRAY);
+    DrawText("7. Executing Scripts: Press 'E' to execute the current script (Python or compile C).", helpX, helpY + 220, 20, DARKGRAY);
+    DrawText("8. Creating Descriptions: Right-click a script button to create a description file.", helpX, helpY + 250, 20, DARKGRAY);
+    DrawText("9. Existing Scripts: Green buttons indicate scripts that exist in 'gameFiles'.", helpX, helpY + 280, 20, DARKGRAY);
+    DrawText("10. Toggle Help Menu: Press 'H' to show or hide this help menu.", helpX, helpY + 310, 20, DARKGRAY);
+    DrawText("11. Large Grids: Wheel or UP/DOWN scrolls, Shift+wheel scrolls sideways, Ctrl+wheel or +/- zooms,", helpX, helpY + 340, 20, DARKGRAY);
+    DrawText("    middle-drag pans and Home resets the view. Start with -g COLSxROWS to change the grid size.", helpX, helpY + 370, 20, DARKGRAY);
+    DrawText("12. Build All: 'B' compiles every C script in this grid, Shift+B in all grids; unchanged", helpX, helpY + 400, 20, DARKGRAY);
+    DrawText("    scripts are reused from the cache. Start with --build-all to build without a window.", helpX, helpY + 430, 20, DARKGRAY);
+    DrawText("13. Run History: Bars under each button show its last runs, green fast to red slow. Start", helpX, helpY + 460, 20, DARKGRAY);
+    DrawText("    with -t SECONDS, -c CPU_SECONDS or -m MB to limit runs (Linux only).", helpX, helpY + 490, 20, DARKGRAY);
+    DrawText("14. Pipelines: Ctrl+click scripts in order, then 'P' runs them with each one's output piped", helpX, helpY + 520, 20, DARKGRAY);
+    DrawText("    into the next. Stage timings appear in the last script's console.", helpX, helpY + 550, 20, DARKGRAY);
+    DrawText("15. Profiler: F3 shows frame times, file calls and queues; F4 saves " PROFILE_TRACE_PATH ".", helpX, helpY + 580, 20, DARKGRAY);
+}
+
+void DrawFeedbackPanel() {
+    int panelX = 620;
+    int panelY = 10;
+    DrawRectangle(panelX - 10, panelY - 10, 190, 150, LIGHTGRAY);
+    DrawText("FEEDBACK PANEL", panelX, panelY, 20, DARKGRAY);
+    DrawText(TextFormat("Current Grid: %d", currentGridIndex + 1), panelX, panelY + 30, 20, DARKGRAY);
+    DrawText(TextFormat("Mode: %s", isCFile ? "C" : "Python"), panelX, panelY + 50, 20, DARKGRAY);
+    DrawText(TextFormat("Edit Mode: %s", isEditingMode ? "Editing" : "Executing"), panelX, panelY + 70, 20, DARKGRAY);
+
+    if (selectedScriptIndex != -1) {
+        Script* script = GetGridScript(currentGridIndex, selectedScriptIndex);
+        DrawText(TextFormat("Selected Script: %s", script->filename), panelX, panelY + 90, 20, DARKGRAY);
+        if (ScriptFileExists(script)) {
+            DrawText("File Status: Exists", panelX, panelY + 110, 20, GREEN);
+        } else {
+            DrawText("File Status: New", panelX, panelY + 110, 20, RED);
+        }
+    }
+}
+
+// One readdir() pass over gameFiles/ instead of probing every slot, plus
+// the slots held in the packed store
+void ScanGameFiles() {
+    for (uint32_t i = 0; i < packEntryCount; i++) {
+        const PackEntry* entry = &packEntries[i];
+        if (entry->kind == PACK_PY || entry->kind == PACK_C) {
+            Script* script = GetScript(entry->scriptNumber);
+            script->status.flags |= entry->kind == PACK_C ? STATUS_C : STATUS_PY;
+            if ((entry->scriptNumber - 1) / scriptsPerGrid + 2 > gridCount) {
+                gridCount = (entry->scriptNumber - 1) / scriptsPerGrid + 2;
+            }
+        }
+    }
+
+    DIR* dir = opendir(GAME_FILES_PATH);
+    if (!dir) {
+        return;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        bool isC;
+        int scriptNumber = ParseScriptFilename(entry->d_name, &isC);
+        if (scriptNumber == 0) {
+            scriptNumber = ParseEncodedFilename(entry->d_name, &isC);
+        }
+        if (scriptNumber > 0) {
+            Script* script = GetScript(scriptNumber);
+            script->status.flags |= isC ? STATUS_C : STATUS_PY;
+            if ((scriptNumber - 1) / scriptsPerGrid + 2 > gridCount) {
+                gridCount = (scriptNumber - 1) / scriptsPerGrid + 2;
+            }
+        }
+    }
+    closedir(dir);
+}
+
+void InitializeAndLoadExistingScripts() {
+    // First make sure the gameFiles directory exists
+    #ifdef _WIN32
+    _mkdir(GAME_FILES_PATH);
+    _mkdir(BUILD_CACHE_PATH);
+    #else
+    mkdir(GAME_FILES_PATH, 0777);
+    mkdir(BUILD_CACHE_PATH, 0777);
+    #endif
+    PruneBuildCache();
+
+    OpenScriptPack();
+    if (!charMapPath) {
+        static char registryMapPath[REGISTRY_PATH_LENGTH];
+        Registry* registry = registry_open(".");
+        int mapId = registry_find_role(registry, CHAR_MAP_ROLE);
+        charMapPath = registry_path(registry, mapId >= 0 ? mapId : CHAR_MAP_ID, registryMapPath, sizeof(registryMapPath));
+        registry_close(registry);
+    }
+    LoadCharMap(charMapPath);
+    ScanGameFiles();
+
+    // Slots created by the scan were named before their flags were known
+    pthread_mutex_lock(&slotLock);
+    for (int i = 0; i < slotCapacity; i++) {
+        if (slotTable[i]) {
+            ChooseScriptFile(slotTable[i]);
+        }
+    }
+    pthread_mutex_unlock(&slotLock);
+}
+
+void StartScriptLoader() {
+    pthread_t thread;
+    pthread_create(&thread, NULL, ScriptLoaderThread, NULL);
+    pthread_detach(thread);
+}
+
+// Queue a grid for background loading. Grids come back into the queue
+// when shown again, since their text may have been evicted meanwhile.
+void RequestGridLoad(int gridIndex) {
+    pthread_mutex_lock(&loadQueueLock);
+    bool queued = false;
+    for (int i = 0; i < loadQueueCount; i++) {
+        queued = queued || loadQueue[i] == gridIndex;
+    }
+    if (!queued) {
+        if (loadQueueCount == LOAD_QUEUE_SIZE) {
+            // Drop the oldest request, it is no longer on screen
+            memmove(loadQueue, loadQueue + 1, (LOAD_QUEUE_SIZE - 1) * sizeof(int));
+            loadQueueCount--;
+        }
+        loadQueue[loadQueueCount++] = gridIndex;
+        pthread_cond_signal(&loadQueueReady);
+    }
+    pthread_mutex_unlock(&loadQueueLock);
+}
+
+// Index every script found at startup in the background. They are queued
+// in number order so each posting list is built by appending.
+void StartSearchIndexer() {
+    int* numbers = malloc((slotCount + 1) * sizeof(int));
+    int count = 0;
+    for (int i = 0; i < slotCapacity; i++) {
+        if (slotTable[i] && slotTable[i]->status.flags) {
+            numbers[count++] = slotTable[i]->number;
+        }
+    }
+    qsort(numbers, count, sizeof(int), CompareUnsigned);
+    for (int i = 0; i < count; i++) {
+        QueueIndexUpdate(numbers[i]);
+    }
+    free(numbers);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, SearchIndexThread, NULL);
+    pthread_detach(thread);
+}
+
+// Ask the indexer to re-read a script's files (or drop them if deleted)
+void QueueIndexUpdate(int scriptNumber) {
+    Script* script = GetScript(scriptNumber);
+    pthread_mutex_lock(&indexQueueLock);
+    script->indexFlags = script->status.flags;  // the indexer reads this copy
+    if (!script->indexPending) {
+        if (indexQueueCount == indexQueueCapacity) {
+            indexQueueCapacity = indexQueueCapacity ? indexQueueCapacity * 2 : 1024;
+            indexQueue = realloc(indexQueue, indexQueueCapacity * sizeof(int));
+        }
+        indexQueue[indexQueueCount++] = scriptNumber;
+        script->indexPending = true;
+        pthread_cond_signal(&indexQueueReady);
+    }
+    pthread_mutex_unlock(&indexQueueLock);
+}
+
+int CompareUnsigned(const void* a, const void* b) {
+    unsigned int x = *(const unsigned int*)a;
+    unsigned int y = *(const unsigned int*)b;
+    return (x > y) - (x < y);
+}
+
+// Sorted, distinct lower-cased trigrams of a text. Returns the count.
+// Duplicates are dropped with a per-thread bitmap over all 2^24 trigrams,
+// so only the distinct ones get sorted.
+int ExtractTrigrams(const char* text, size_t length, unsigned int** trigrams) {
+    static _Thread_local unsigned char* seen = NULL;
+    *trigrams = NULL;
+    if (length < 3) {
+        return 0;
+    }
+    if (!seen) {
+        seen = calloc(1 << 21, 1);
+    }
+
+    unsigned int* distinct = malloc((length - 2) * sizeof(unsigned int));
+    int count = 0;
+    unsigned int trigram = ((unsigned int)tolower((unsigned char)text[0]) << 8) | (unsigned int)tolower((unsigned char)text[1]);
+    for (size_t i = 2; i < length; i++) {
+        trigram = ((trigram << 8) | (unsigned int)tolower((unsigned char)text[i])) & 0xFFFFFF;
+        if (!(seen[trigram >> 3] & (1 << (trigram & 7)))) {
+            seen[trigram >> 3] |= 1 << (trigram & 7);
+            distinct[count++] = trigram;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        seen[distinct[i] >> 3] = 0;
+    }
+    qsort(distinct, count, sizeof(unsigned int), CompareUnsigned);
+    *trigrams = distinct;
+    return count;
+}
+
+// Posting list of a trigram in the open-addressing table. Called with
+// searchLock held.
+PostingList* FindPostingList(unsigned int trigram, bool create) {
+    if (create && (postingCount + 1) * 4 > postingCapacity * 3) {
+        int capacity = postingCapacity ? postingCapacity * 2 : 4096;
+        PostingList* table = calloc(capacity, sizeof(PostingList));
+        for (int i = 0; i < postingCapacity; i++) {
+            if (postingTable[i].documents) {
+                unsigned int j = (postingTable[i].trigram * 2654435761u) & (capacity - 1);
+                while (table[j].documents) {
+                    j = (j + 1) & (capacity - 1);
+                }
+                table[j] = postingTable[i];
+            }
+        }
+        free(postingTable);
+        postingTable = table;
+        postingCapacity = capacity;
+    }
+    if (postingCapacity == 0) {
+        return NULL;
+    }
+
+    unsigned int mask = (unsigned int)postingCapacity - 1;
+    unsigned int i = (trigram * 2654435761u) & mask;
+    while (postingTable[i].documents && postingTable[i].trigram != trigram) {
+        i = (i + 1) & mask;
+    }
+    if (!postingTable[i].documents) {
+        if (!create) {
+            return NULL;
+        }
+        postingTable[i].trigram = trigram;
+        postingTable[i].capacity = 4;
+        postingTable[i].documents = malloc(4 * sizeof(int));
+        postingTable[i].count = 0;
+        postingCount++;
+    }
+    return &postingTable[i];
+}
+
+// Replace a document's trigrams in the index. Called with searchLock held.
+void IndexDocument(Script* script, int language, unsigned int* trigrams, int count) {
+    int document = script->number * 2 + language;
+
+    // Remove the old entries; posting lists stay sorted
+    for (int i = 0; i < script->trigramCount[language]; i++) {
+        PostingList* list = FindPostingList(script->trigrams[language][i], false);
+        int low = 0, high = list ? list->count : 0;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (list->documents[middle] < document) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (list && low < list->count && list->documents[low] == document) {
+            memmove(list->documents + low, list->documents + low + 1, (list->count - low - 1) * sizeof(int));
+            list->count--;
+        }
+    }
+    free(script->trigrams[language]);
+
+    for (int i = 0; i < count; i++) {
+        PostingList* list = FindPostingList(trigrams[i], true);
+        int low = 0, high = list->count;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (list->documents[middle] < document) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        if (list->count == list->capacity) {
+            list->capacity *= 2;
+            list->documents = realloc(list->documents, list->capacity * sizeof(int));
+        }
+        memmove(list->documents + low + 1, list->documents + low, (list->count - low) * sizeof(int));
+        list->documents[low] = document;
+        list->count++;
+    }
+    script->trigrams[language] = trigrams;
+    script->trigramCount[language] = count;
+}
+
+void* SearchIndexThread(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&indexQueueLock);
+        while (indexQueueHead == indexQueueCount) {
+            indexQueueHead = indexQueueCount = 0;
+            pthread_cond_wait(&indexQueueReady, &indexQueueLock);
+        }
+        int scriptNumber = indexQueue[indexQueueHead++];
+        Script* script = GetScript(scriptNumber);
+        script->indexPending = false;
+        unsigned char flags = script->indexFlags;
+        bool last = indexQueueHead == indexQueueCount;
+        pthread_mutex_unlock(&indexQueueLock);
+
+        for (int language = 0; language < 2; language++) {
+            unsigned int* trigrams = NULL;
+            int count = 0;
+            if (flags & (language ? STATUS_C : STATUS_PY)) {
+                char filename[100];
+                snprintf(filename, sizeof(filename), language ? GAME_FILES_PATH "script%d.c" : GAME_FILES_PATH "script%d.py", scriptNumber);
+                size_t length;
+                char* text = LoadScriptFromFile(filename, &length);
+                if (text) {
+                    count = ExtractTrigrams(text, length, &trigrams);
+                    free(text);
+                }
+            }
+            if (count > 0 || script->trigramCount[language] > 0) {
+                pthread_mutex_lock(&searchLock);
+                IndexDocument(script, language, trigrams, count);
+                pthread_mutex_unlock(&searchLock);
+            } else {
+                free(trigrams);
+            }
+        }
+
+        atomic_store(&searchIndexChanged, true);
+        if (last) {
+            WakeFrameLoop();
+        }
+    }
+    return NULL;
+}
+
+bool ContainsIgnoreCase(const char* text, const char* query) {
+    size_t length = strlen(query);
+    for (const char* p = text; *p; p++) {
+        size_t i = 0;
+        while (i < length && p[i] && tolower((unsigned char)p[i]) == tolower((unsigned char)query[i])) {
+            i++;
+        }
+        if (i == length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Intersect the posting lists of the query's trigrams, shortest first.
+// Candidates whose text is in the cache are checked for the whole query;
+// the rest are reported on the trigram match alone.
+void RunSearch() {
+    double start = GetTime();
+    searchResultCount = 0;
+    unsigned int* trigrams;
+    int count = ExtractTrigrams(searchQuery, strlen(searchQuery), &trigrams);
+    if (count == 0) {
+        searchTimeMs = 0;
+        return;
+    }
+
+    pthread_mutex_lock(&searchLock);
+    PostingList* lists[SEARCH_QUERY_LENGTH];
+    bool missing = false;
+    for (int i = 0; i < count; i++) {
+        lists[i] = FindPostingList(trigrams[i], false);
+        missing = missing || !lists[i] || lists[i]->count == 0;
+    }
+    int* candidates = NULL;
+    int candidateCount = 0;
+    if (!missing) {
+        for (int i = 1; i < count; i++) {
+            for (int j = i; j > 0 && lists[j]->count < lists[j - 1]->count; j--) {
+                PostingList* swap = lists[j];
+                lists[j] = lists[j - 1];
+                lists[j - 1] = swap;
+            }
+        }
+        candidates = malloc(lists[0]->count * sizeof(int));
+        memcpy(candidates, lists[0]->documents, lists[0]->count * sizeof(int));
+        candidateCount = lists[0]->count;
+        for (int i = 1; i < count && candidateCount > 0; i++) {
+            int kept = 0;
+            int j = 0;
+            for (int c = 0; c < candidateCount; c++) {
+                while (j < lists[i]->count && lists[i]->documents[j] < candidates[c]) {
+                    j++;
+                }
+                if (j < lists[i]->count && lists[i]->documents[j] == candidates[c]) {
+                    candidates[kept++] = candidates[c];
+                }
+            }
+            candidateCount = kept;
+        }
+    }
+    pthread_mutex_unlock(&searchLock);
+    free(trigrams);
+
+    searchResults = realloc(searchResults, (candidateCount + 1) * sizeof(int));
+    for (int c = 0; c < candidateCount; c++) {
+        int scriptNumber = candidates[c] / 2;
+        if (searchResultCount > 0 && searchResults[searchResultCount - 1] == scriptNumber) {
+            continue;
+        }
+        Script* script = FindScript(scriptNumber);
+        bool match = true;
+        pthread_mutex_lock(&scriptTextLock);
+        if (script && script->text && script->isCFile == (candidates[c] % 2 == 1)) {
+            match = ContainsIgnoreCase(script->text, searchQuery);
+        }
+        pthread_mutex_unlock(&scriptTextLock);
+        if (match) {
+            searchResults[searchResultCount++] = scriptNumber;
+        }
+    }
+    free(candidates);
+    searchTimeMs = (GetTime() - start) * 1000.0;
+}
+
+bool IsSearchMatch(int scriptNumber) {
+    int low = 0, high = searchResultCount;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (searchResults[middle] < scriptNumber) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low < searchResultCount && searchResults[low] == scriptNumber;
+}
+
+// Select the first match after the selected script, wrapping around, and
+// bring its grid and cell into view
+void JumpToNextMatch() {
+    if (searchResultCount == 0) {
+        return;
+    }
+    int current = selectedScriptIndex >= 0 ? currentGridIndex * scriptsPerGrid + selectedScriptIndex + 1 : 0;
+    int target = searchResults[0];
+    for (int i = 0; i < searchResultCount; i++) {
+        if (searchResults[i] > current) {
+            target = searchResults[i];
+            break;
+        }
+    }
+
+    int gridIndex = (target - 1) / scriptsPerGrid;
+    if (gridIndex >= gridCount) {
+        gridCount = gridIndex + 1;
+    }
+    if (gridIndex != currentGridIndex) {
+        SwitchGrid(gridIndex);
+    }
+    selectedScriptIndex = (target - 1) % scriptsPerGrid;
+    Rectangle cell = CellRect(selectedScriptIndex);
+    targetScroll.x = scroll.x + cell.x - gridView.x - (gridView.width - cell.width) / 2;
+    targetScroll.y = scroll.y + cell.y - gridView.y - (gridView.height - cell.height) / 2;
+}
+
+// Typing edits the query and re-runs it; Enter jumps to the next match,
+// Esc closes the box
+void HandleSearchInput() {
+    bool edited = false;
+    int key;
+    while ((key = GetCharPressed()) > 0) {
+        size_t length = strlen(searchQuery);
+        if (key >= 32 && key < 127 && length < SEARCH_QUERY_LENGTH - 1) {
+            searchQuery[length] = (char)key;
+            searchQuery[length + 1] = '\0';
+            edited = true;
+        }
+    }
+    if (IsKeyPressed(KEY_BACKSPACE) && searchQuery[0]) {
+        searchQuery[strlen(searchQuery) - 1] = '\0';
+        edited = true;
+    }
+    if (edited || atomic_exchange(&searchIndexChanged, false)) {
+        RunSearch();
+    }
+    if (IsKeyPressed(KEY_ENTER)) {
+        JumpToNextMatch();
+    }
+    if (IsKeyPressed(KEY_ESCAPE)) {
+        searchActive = false;
+        searchResultCount = 0;
+        SetExitKey(KEY_ESCAPE);
     }
 }
 
-void LoadScriptFromFile(const char* filename, char* textBuffer, int bufferSize) {
-    FILE* file = fopen(filename, "r");
-    if (file) {
-        // Read entire file into buffer, not just one line
-        size_t bytesRead = fread(textBuffer, 1, bufferSize - 1, file);
-        textBuffer[bytesRead] = '\0'; // Ensure null termination
-        fclose(file);
+void DrawSearchBar(int screenWidth, int screenHeight) {
+    DrawRectangle(0, screenHeight - 30, screenWidth, 30, SKYBLUE);
+    pthread_mutex_lock(&indexQueueLock);
+    int pending = indexQueueCount - indexQueueHead;
+    pthread_mutex_unlock(&indexQueueLock);
+
+    const char* status;
+    if (strlen(searchQuery) < 3) {
+        status = "type at least 3 characters";
     } else {
-        // Initialize buffer to empty string if file can't be opened
-        textBuffer[0] = '\0';
+        status = TextFormat("%d scripts, %.2f ms", searchResultCount, searchTimeMs);
     }
+    DrawText(TextFormat("SEARCH: %s_   (%s%s)  [Enter] Next match [Esc] Close", searchQuery, status,
+            pending > 0 ? TextFormat(", indexing %d", pending) : ""), 10, screenHeight - 25, 20, DARKBLUE);
 }
 
-bool DoesFileExist(const char* filename) {
-    struct stat buffer;
-    return (stat(filename, &buffer) == 0);
-}
+// Open a file in the in-app editor; a missing file starts empty. Refused
+// while the open file has unsaved changes.
+bool OpenEditor(const char* filename, int scriptNumber) {
+    if (editor.open && editor.dirty) {
+        snprintf(editor.message, sizeof(editor.message), "Save (Ctrl+S) or close (Esc) this file first.");
+        return false;
+    }
+    CloseEditor();
 
-void* ExecuteCommand(void* arg) {
-    char* command = (char*)arg;
-    system(command);
-    free(command);
-    return NULL;
+    size_t length = 0;
+    char* text = LoadScriptFromFile(filename, &length);
+    editor.buffer.capacity = length + EDITOR_GAP_SIZE;
+    editor.buffer.data = malloc(editor.buffer.capacity);
+    editor.buffer.gapStart = 0;
+    editor.buffer.gapEnd = EDITOR_GAP_SIZE;
+    if (text) {
+        memcpy(editor.buffer.data + EDITOR_GAP_SIZE, text, length);
+        free(text);
+    }
+    snprintf(editor.filename, sizeof(editor.filename), "%s", filename);
+    editor.scriptNumber = scriptNumber;
+    editor.column = SIZE_MAX;
+    editor.open = true;
+    if (scriptNumber > 0) {
+        GetScript(scriptNumber)->isEditing = true;
+    }
+    SetExitKey(KEY_NULL);  // Esc closes the editor instead of the window
+    return true;
 }
 
-void RunCommandAsync(const char* command) {
-    pthread_t thread;
-    char* commandCopy = strdup(command);
-    pthread_create(&thread, NULL, ExecuteCommand, commandCopy);
-    pthread_detach(thread);
+void CloseEditor() {
+    if (editor.open && editor.scriptNumber > 0) {
+        GetScript(editor.scriptNumber)->isEditing = false;
+    }
+    free(editor.buffer.data);
+    memset(&editor, 0, sizeof(editor));
+    SetExitKey(KEY_ESCAPE);
 }
 
-void OpenScriptInNotepad(const char* filename) {
-    char command[256];
-    snprintf(command, sizeof(command), "notepad %s", filename);
-    RunCommandAsync(command);
-}
+// Write the buffer to a temporary file and rename it over the original,
+// so a crash mid-save never leaves a half-written script. The status and
+// text caches are updated here instead of waiting for the file watcher.
+bool SaveEditor() {
+    GapBuffer* buffer = &editor.buffer;
+    char temporary[160];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", editor.filename);
+    FILE* file = ProfiledFopen(temporary, "wb");
+    bool ok = file != NULL;
+    if (ok) {
+        size_t tail = buffer->capacity - buffer->gapEnd;
+        ok = fwrite(buffer->data, 1, buffer->gapStart, file) == buffer->gapStart &&
+                fwrite(buffer->data + buffer->gapEnd, 1, tail, file) == tail && fflush(file) == 0;
+#ifndef _WIN32
+        ok = ok && fsync(fileno(file)) == 0;
+#endif
+        ok = fclose(file) == 0 && ok;
+    }
+#ifdef _WIN32
+    // rename() will not replace an existing file on Windows
+    if (ok) {
+        remove(editor.filename);
+    }
+#endif
+    if (!ok || rename(temporary, editor.filename) != 0) {
+        remove(temporary);
+        snprintf(editor.message, sizeof(editor.message), "Could not save %s.", editor.filename);
+        return false;
+    }
 
-void ExecutePythonScript(const char* filename) {
-    char command[256];
-    snprintf(command, sizeof(command), "python %s", filename);
-    RunCommandAsync(command);
+    if (editor.scriptNumber > 0) {
+        Script* script = GetScript(editor.scriptNumber);
+        size_t length = buffer->capacity - (buffer->gapEnd - buffer->gapStart);
+        char* text = malloc(length + 1);
+        if (text) {
+            memcpy(text, buffer->data, buffer->gapStart);
+            memcpy(text + buffer->gapStart, buffer->data + buffer->gapEnd, buffer->capacity - buffer->gapEnd);
+            text[length] = '\0';
+        }
+        bool isC;
+        ParseScriptFilename(editor.filename, &isC);
+        script->status.flags |= isC ? STATUS_C : STATUS_PY;
+        script->status.mtime = time(NULL);
+        SetScriptText(script, text, text ? length : 0);
+        QueueIndexUpdate(editor.scriptNumber);
+    }
+    editor.dirty = false;
+    editor.confirmClose = false;
+    snprintf(editor.message, sizeof(editor.message), "Saved.");
+    return true;
 }
 
-void CompileAndExecuteCFile(const char* filename) {
-    // Compile the C file into an executable named 'output.exe'
-    char command[512];
-    
-    // Create the output file path based on the input file
-    char outputFile[256];
-    snprintf(outputFile, sizeof(outputFile), "output_%d.exe", currentGridIndex);
-
-    // Format the compile command
-    snprintf(command, sizeof(command), "gcc %s -o %s 2> compile_errors.txt", filename, outputFile);
+// Byte at a logical position, skipping over the gap
+char EditorCharAt(size_t position) {
+    GapBuffer* buffer = &editor.buffer;
+    return position < buffer->gapStart ? buffer->data[position] : buffer->data[position + buffer->gapEnd - buffer->gapStart];
+}
 
-    // Run the compile command synchronously to wait for compilation to complete
-    system(command);
+size_t EditorLength() {
+    return editor.buffer.capacity - (editor.buffer.gapEnd - editor.buffer.gapStart);
+}
 
-    // Check if the compilation was successful before running
-    FILE *file = fopen("compile_errors.txt", "r");
-    if (file) {
-        // Get file size to check if there are any errors
-        fseek(file, 0, SEEK_END);
-        long fileSize = ftell(file);
-        fseek(file, 0, SEEK_SET);
-        
-        if (fileSize == 0) {
-            // No errors, so run the executable
-            snprintf(command, sizeof(command), "%s", outputFile);
-            RunCommandAsync(command);
-        } else {
-            // Display compilation errors to the user
-            char errorLine[256];
-            fgets(errorLine, sizeof(errorLine), file);
-            // Display first error line
-            DrawText(errorLine, 10, 560, 20, RED);
-            printf("Compilation failed. Check 'compile_errors.txt' for details.\n");
-            // Open the error file in notepad
-            OpenScriptInNotepad("compile_errors.txt");
-        }
-        fclose(file);
+size_t EditorLineStart(size_t position) {
+    while (position > 0 && EditorCharAt(position - 1) != '\n') {
+        position--;
     }
+    return position;
 }
 
-void CreateNewScript(int gridIndex, int scriptIndex) {
-    selectedScriptIndex = scriptIndex;
-    grids[gridIndex].scripts[scriptIndex].isEditing = true;
-
-    if (isCFile) {
-        snprintf(grids[gridIndex].scripts[scriptIndex].filename, sizeof(grids[gridIndex].scripts[scriptIndex].filename), 
-                GAME_FILES_PATH "script%d.c", gridIndex * MAX_SCRIPTS + scriptIndex + 1);
-    } else {
-        snprintf(grids[gridIndex].scripts[scriptIndex].filename, sizeof(grids[gridIndex].scripts[scriptIndex].filename), 
-                GAME_FILES_PATH "script%d.py", gridIndex * MAX_SCRIPTS + scriptIndex + 1);
+size_t EditorLineEnd(size_t position) {
+    size_t length = EditorLength();
+    while (position < length && EditorCharAt(position) != '\n') {
+        position++;
     }
-    grids[gridIndex].scripts[scriptIndex].isCFile = isCFile;
+    return position;
+}
 
-    if (!DoesFileExist(grids[gridIndex].scripts[scriptIndex].filename)) {
-        // Initialize with appropriate template based on file type
-        if (isCFile) {
-            SaveScriptToFile(grids[gridIndex].scripts[scriptIndex].filename, 
-                "#include <stdio.h>\n\nint main() {\n    printf(\"Hello, World!\\n\");\n    return 0;\n}\n");
-        } else {
-            SaveScriptToFile(grids[gridIndex].scripts[scriptIndex].filename, 
-                "# Python Script Template\nprint(\"Hello, World!\")\n");
+// Move the gap to position, keeping cursorLine in step
+void EditorMoveTo(size_t position) {
+    GapBuffer* buffer = &editor.buffer;
+    size_t gap = buffer->gapEnd - buffer->gapStart;
+    if (position < buffer->gapStart) {
+        for (size_t i = position; i < buffer->gapStart; i++) {
+            editor.cursorLine -= buffer->data[i] == '\n';
+        }
+        size_t count = buffer->gapStart - position;
+        memmove(buffer->data + buffer->gapEnd - count, buffer->data + position, count);
+    } else if (position > buffer->gapStart) {
+        size_t count = position - buffer->gapStart;
+        for (size_t i = 0; i < count; i++) {
+            editor.cursorLine += buffer->data[buffer->gapEnd + i] == '\n';
         }
+        memmove(buffer->data + buffer->gapStart, buffer->data + buffer->gapEnd, count);
     }
-    
-    // Load the script content into memory
-    LoadScriptFromFile(grids[gridIndex].scripts[scriptIndex].filename, 
-                      grids[gridIndex].scripts[scriptIndex].text, 
-                      MAX_TEXT_LENGTH);
-    
-    // Open the script in notepad for editing
-    OpenScriptInNotepad(grids[gridIndex].scripts[scriptIndex].filename);
+    buffer->gapStart = position;
+    buffer->gapEnd = position + gap;
 }
 
-void CreateDescriptionFile(const char* scriptFilename) {
-    char descriptionFilename[256];
-    snprintf(descriptionFilename, sizeof(descriptionFilename), "%s_description.txt", scriptFilename);
-
-    if (!DoesFileExist(descriptionFilename)) {
-        FILE* file = fopen(descriptionFilename, "w");
-        if (file) {
-            fprintf(file, "Description for %s\n\nEnter your description here.\n", scriptFilename);
-            fclose(file);
+void EditorInsert(const char* text, size_t length) {
+    GapBuffer* buffer = &editor.buffer;
+    if (buffer->gapEnd - buffer->gapStart < length) {
+        // Grow the gap: double the buffer and move the text after the cursor up
+        size_t tail = buffer->capacity - buffer->gapEnd;
+        size_t capacity = buffer->capacity * 2 + length;
+        char* data = realloc(buffer->data, capacity);
+        if (!data) {
+            return;
         }
+        memmove(data + capacity - tail, data + buffer->gapEnd, tail);
+        buffer->data = data;
+        buffer->gapEnd = capacity - tail;
+        buffer->capacity = capacity;
     }
-    
-    // Open the description file in notepad for editing
-    OpenScriptInNotepad(descriptionFilename);
+    memcpy(buffer->data + buffer->gapStart, text, length);
+    buffer->gapStart += length;
+    for (size_t i = 0; i < length; i++) {
+        editor.cursorLine += text[i] == '\n';
+    }
+    editor.dirty = true;
 }
 
-void SwitchGrid(int gridID) {
-    if (gridID >= 0 && gridID < MAX_GRIDS) {
-        currentGridIndex = gridID;
-        selectedScriptIndex = -1;
+void EditorDelete(bool forward) {
+    GapBuffer* buffer = &editor.buffer;
+    if (forward && buffer->gapEnd < buffer->capacity) {
+        buffer->gapEnd++;
+    } else if (!forward && buffer->gapStart > 0) {
+        editor.cursorLine -= buffer->data[--buffer->gapStart] == '\n';
+    } else {
+        return;
     }
+    editor.column = SIZE_MAX;
+    editor.dirty = true;
 }
 
-void ToggleScriptMode() {
-    // Toggle between Python mode and C mode
-    isCFile = !isCFile;
-    
-    // Reset the selected script index when changing modes
-    selectedScriptIndex = -1;
+// Move the first visible line a line at a time until the cursor shows
+void EditorScrollToCursor(int visibleLines) {
+    while (editor.cursorLine < editor.topLine && editor.topOffset > 0) {
+        editor.topOffset = EditorLineStart(editor.topOffset - 1);
+        editor.topLine--;
+    }
+    while (editor.cursorLine >= editor.topLine + visibleLines) {
+        editor.topOffset = EditorLineEnd(editor.topOffset) + 1;
+        editor.topLine++;
+    }
 }
 
-void ToggleEditMode() {
-    isEditingMode = !isEditingMode;
+// Pressed, or held long enough to repeat
+bool EditorKeyRepeat(int key) {
+    if (IsKeyPressed(key)) {
+        editor.repeatKey = key;
+        editor.repeatAt = GetTime() + 0.4;
+        return true;
+    }
+    if (key == editor.repeatKey && IsKeyDown(key) && GetTime() >= editor.repeatAt) {
+        editor.repeatAt = GetTime() + 0.04;
+        return true;
+    }
+    return false;
 }
 
-void DrawHelpMenu() {
-    int helpX = 20;
-    int helpY = 100;
-    DrawRectangle(10, 90, 780, 400, LIGHTGRAY);
-    DrawText("HELP MENU", helpX, helpY, 30, DARKGRAY);
-    DrawText("1. Grid Navigation: Use LEFT and RIGHT arrow keys to switch grids.", helpX, helpY + 40, 20, DARKGRAY);
-    DrawText("2. Python/C Mode Toggle: Press '1' to switch between Python and C modes.", helpX, helpY + 70, 20, DARKGRAY);
-    DrawText("3. Edit/Execute Mode Toggle: Press '2' to toggle between Editing and Executing modes.", helpX, helpY + 100, 20, DARKGRAY);
-    DrawText("4. Creating Scripts: Click on a grid button to create a new script in the selected mode.", helpX, helpY + 130, 20, DARKGRAY);
-    DrawText("5. Editing Scripts: Click on an existing script button to edit the script in Notepad.", helpX, helpY + 160, 20, DARKGRAY);
-    DrawText("6. Saving Scripts: Press 'S' to save the currently opened script.", helpX, helpY + 190, 20, DARKGRAY);
-    DrawText("7. Executing Scripts: Press 'E' to execute the current script (Python or compile C).", helpX, helpY + 220, 20, DARKGRAY);
-    DrawText("8. Creating Descriptions: Right-click a script button to create a description file.", helpX, helpY + 250, 20, DARKGRAY);
-    DrawText("9. Existing Scripts: Green buttons indicate scripts that exist in 'gameFiles'.", helpX, helpY + 280, 20, DARKGRAY);
-    DrawText("10. Toggle Help Menu: Press 'H' to show or hide this help menu.", helpX, helpY + 310, 20, DARKGRAY);
-}
+void HandleEditorInput(int screenHeight) {
+    int visibleLines = (screenHeight - 70) / EDITOR_LINE_HEIGHT;
+    bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    size_t cursor = editor.buffer.gapStart;
+    size_t lineStart = EditorLineStart(cursor);
 
-void DrawFeedbackPanel() {
-    int panelX = 620;
-    int panelY = 10;
-    DrawRectangle(panelX - 10, panelY - 10, 190, 150, LIGHTGRAY);
-    DrawText("FEEDBACK PANEL", panelX, panelY, 20, DARKGRAY);
-    DrawText(TextFormat("Current Grid: %d", currentGridIndex + 1), panelX, panelY + 30, 20, DARKGRAY);
-    DrawText(TextFormat("Mode: %s", isCFile ? "C" : "Python"), panelX, panelY + 50, 20, DARKGRAY);
-    DrawText(TextFormat("Edit Mode: %s", isEditingMode ? "Editing" : "Executing"), panelX, panelY + 70, 20, DARKGRAY);
+    int key;
+    while ((key = GetCharPressed()) > 0) {
+        if (key >= 32 && key < 127) {
+            char c = (char)key;
+            EditorInsert(&c, 1);
+        }
+    }
+    if (EditorKeyRepeat(KEY_ENTER)) {
+        // Carry the current line's indentation over
+        char indent[128] = "\n";
+        size_t length = 1;
+        while (length < sizeof(indent) && lineStart + length - 1 < cursor &&
+                (EditorCharAt(lineStart + length - 1) == ' ' || EditorCharAt(lineStart + length - 1) == '\t')) {
+            indent[length] = EditorCharAt(lineStart + length - 1);
+            length++;
+        }
+        EditorInsert(indent, length);
+    }
+    if (EditorKeyRepeat(KEY_TAB)) {
+        EditorInsert("    ", EDITOR_TAB_WIDTH);
+    }
+    if (EditorKeyRepeat(KEY_BACKSPACE)) {
+        EditorDelete(false);
+    }
+    if (EditorKeyRepeat(KEY_DELETE)) {
+        EditorDelete(true);
+    }
+    if (EditorKeyRepeat(KEY_LEFT) && editor.buffer.gapStart > 0) {
+        EditorMoveTo(editor.buffer.gapStart - 1);
+    }
+    if (EditorKeyRepeat(KEY_RIGHT) && editor.buffer.gapStart < EditorLength()) {
+        EditorMoveTo(editor.buffer.gapStart + 1);
+    }
+    if (editor.buffer.gapStart != cursor) {
+        // Typing or a sideways move forgets the wanted column
+        cursor = editor.buffer.gapStart;
+        lineStart = EditorLineStart(cursor);
+        editor.column = SIZE_MAX;
+    }
+    int lines = 0;
+    if (EditorKeyRepeat(KEY_UP)) {
+        lines = -1;
+    }
+    if (EditorKeyRepeat(KEY_DOWN)) {
+        lines = 1;
+    }
+    if (EditorKeyRepeat(KEY_PAGE_UP)) {
+        lines = -visibleLines;
+    }
+    if (EditorKeyRepeat(KEY_PAGE_DOWN)) {
+        lines = visibleLines;
+    }
+    if (lines != 0) {
+        if (editor.column == SIZE_MAX) {
+            editor.column = cursor - lineStart;
+        }
+        size_t target = lineStart;
+        for (; lines < 0 && target > 0; lines++) {
+            target = EditorLineStart(target - 1);
+        }
+        for (; lines > 0; lines--) {
+            size_t end = EditorLineEnd(target);
+            if (end == EditorLength()) {
+                break;
+            }
+            target = end + 1;
+        }
+        size_t end = EditorLineEnd(target);
+        EditorMoveTo(target + editor.column < end ? target + editor.column : end);
+    }
+    if (IsKeyPressed(KEY_HOME)) {
+        EditorMoveTo(control ? 0 : lineStart);
+        editor.column = SIZE_MAX;
+    }
+    if (IsKeyPressed(KEY_END)) {
+        EditorMoveTo(control ? EditorLength() : EditorLineEnd(cursor));
+        editor.column = SIZE_MAX;
+    }
 
-    if (selectedScriptIndex != -1) {
-        DrawText(TextFormat("Selected Script: %s", grids[currentGridIndex].scripts[selectedScriptIndex].filename), panelX, panelY + 90, 20, DARKGRAY);
-        if (DoesFileExist(grids[currentGridIndex].scripts[selectedScriptIndex].filename)) {
-            DrawText("File Status: Exists", panelX, panelY + 110, 20, GREEN);
+    // Click to place the cursor
+    Vector2 mouse = GetMousePosition();
+    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && mouse.y >= 40 && mouse.x >= EDITOR_GUTTER) {
+        size_t target = editor.topOffset;
+        for (int line = (int)(mouse.y - 40) / EDITOR_LINE_HEIGHT; line > 0; line--) {
+            size_t end = EditorLineEnd(target);
+            if (end == EditorLength()) {
+                break;
+            }
+            target = end + 1;
+        }
+        size_t end = EditorLineEnd(target);
+        char prefix[2] = { 0, 0 };
+        float x = EDITOR_GUTTER + 10;
+        while (target < end) {
+            prefix[0] = EditorCharAt(target);
+            float width = prefix[0] == '\t' ? MeasureText("    ", EDITOR_FONT_SIZE) : MeasureText(prefix, EDITOR_FONT_SIZE) + 2;
+            if (x + width / 2 > mouse.x) {
+                break;
+            }
+            x += width;
+            target++;
+        }
+        EditorMoveTo(target);
+        editor.column = SIZE_MAX;
+    }
+    float wheel = GetMouseWheelMove();
+    if (wheel != 0) {
+        for (int i = 0; i < 3; i++) {
+            if (wheel > 0 && editor.topOffset > 0) {
+                editor.topOffset = EditorLineStart(editor.topOffset - 1);
+                editor.topLine--;
+            } else if (wheel < 0 && EditorLineEnd(editor.topOffset) < EditorLength()) {
+                editor.topOffset = EditorLineEnd(editor.topOffset) + 1;
+                editor.topLine++;
+            }
+        }
+    } else {
+        EditorScrollToCursor(visibleLines);
+    }
+
+    if (control && IsKeyPressed(KEY_S)) {
+        SaveEditor();
+    }
+    if (IsKeyPressed(KEY_ESCAPE)) {
+        if (editor.dirty && !editor.confirmClose) {
+            editor.confirmClose = true;
+            snprintf(editor.message, sizeof(editor.message), "Unsaved changes: Esc again discards them, Ctrl+S saves.");
         } else {
-            DrawText("File Status: New", panelX, panelY + 110, 20, RED);
+            CloseEditor();
         }
     }
 }
 
-void InitializeAndLoadExistingScripts() {
-    // First make sure the gameFiles directory exists
-    #ifdef _WIN32
-    _mkdir(GAME_FILES_PATH);
-    #else
-    mkdir(GAME_FILES_PATH, 0777);
-    #endif
+// Visible lines only, read straight out of the gap buffer
+void DrawEditor(int screenWidth, int screenHeight) {
+    DrawRectangle(0, 0, screenWidth, 36, LIGHTGRAY);
+    DrawText(TextFormat("%s%s   line %d", editor.filename, editor.dirty ? " *" : "", editor.cursorLine + 1),
+            10, 8, 20, DARKGRAY);
+    DrawRectangle(0, 36, EDITOR_GUTTER, screenHeight - 66, (Color){ 230, 230, 230, 255 });
 
-    for (int i = 0; i < MAX_GRIDS; i++) {
-        grids[i].gridID = i;
-        for (int j = 0; j < MAX_SCRIPTS; j++) {
-            grids[i].scripts[j].isEditing = false;
-            grids[i].scripts[j].text[0] = '\0';
-            
-            // Check for Python scripts
-            char pythonFilename[100];
-            snprintf(pythonFilename, sizeof(pythonFilename), GAME_FILES_PATH "script%d.py", i * MAX_SCRIPTS + j + 1);
-            
-            // Check for C scripts
-            char cFilename[100];
-            snprintf(cFilename, sizeof(cFilename), GAME_FILES_PATH "script%d.c", i * MAX_SCRIPTS + j + 1);
-            
-            // Set filename based on what exists
-            if (DoesFileExist(pythonFilename)) {
-                strcpy(grids[i].scripts[j].filename, pythonFilename);
-                grids[i].scripts[j].isCFile = false;
-                LoadScriptFromFile(grids[i].scripts[j].filename, grids[i].scripts[j].text, MAX_TEXT_LENGTH);
-            } else if (DoesFileExist(cFilename)) {
-                strcpy(grids[i].scripts[j].filename, cFilename);
-                grids[i].scripts[j].isCFile = true;
-                LoadScriptFromFile(grids[i].scripts[j].filename, grids[i].scripts[j].text, MAX_TEXT_LENGTH);
-            } else {
-                // Set a default empty filename based on current mode
-                if (isCFile) {
-                    snprintf(grids[i].scripts[j].filename, sizeof(grids[i].scripts[j].filename), 
-                            GAME_FILES_PATH "script%d.c", i * MAX_SCRIPTS + j + 1);
-                } else {
-                    snprintf(grids[i].scripts[j].filename, sizeof(grids[i].scripts[j].filename), 
-                            GAME_FILES_PATH "script%d.py", i * MAX_SCRIPTS + j + 1);
+    size_t length = EditorLength();
+    size_t position = editor.topOffset;
+    int visibleLines = (screenHeight - 70) / EDITOR_LINE_HEIGHT;
+    char line[512];
+    for (int row = 0; row < visibleLines && position <= length; row++) {
+        // Expand tabs as the click handler measures them
+        size_t used = 0;
+        size_t cursorColumn = (size_t)-1;
+        size_t end = EditorLineEnd(position);
+        for (size_t i = position; i <= end && used < sizeof(line) - EDITOR_TAB_WIDTH - 1; i++) {
+            if (i == editor.buffer.gapStart) {
+                cursorColumn = used;
+            }
+            if (i == end) {
+                break;
+            }
+            char c = EditorCharAt(i);
+            if (c == '\t') {
+                for (int t = 0; t < EDITOR_TAB_WIDTH; t++) {
+                    line[used++] = ' ';
                 }
-                grids[i].scripts[j].isCFile = isCFile;
+            } else {
+                line[used++] = c;
+            }
+        }
+        line[used] = '\0';
+
+        int y = 40 + row * EDITOR_LINE_HEIGHT;
+        DrawText(TextFormat("%d", editor.topLine + row + 1), 6, y, EDITOR_FONT_SIZE, GRAY);
+        DrawText(line, EDITOR_GUTTER + 10, y, EDITOR_FONT_SIZE, BLACK);
+        if (cursorColumn != (size_t)-1) {
+            line[cursorColumn] = '\0';
+            int x = EDITOR_GUTTER + 10 + MeasureText(line, EDITOR_FONT_SIZE) + (cursorColumn > 0 ? 1 : 0);
+            DrawRectangle(x, y, 2, EDITOR_FONT_SIZE, MAROON);
+        }
+        if (end == length) {
+            break;
+        }
+        position = end + 1;
+    }
+
+    DrawRectangle(0, screenHeight - 30, screenWidth, 30, LIGHTGRAY);
+    DrawText(editor.message[0] ? editor.message : "EDITOR: [Ctrl+S] Save [Esc] Close [Ctrl+Home/End] Top/Bottom",
+            10, screenHeight - 25, 20, editor.confirmClose ? RED : DARKGRAY);
+}
+
+void* ScriptLoaderThread(void* arg) {
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&loadQueueLock);
+        while (loadQueueCount == 0) {
+            pthread_cond_wait(&loadQueueReady, &loadQueueLock);
+        }
+        // Most recent request first: that is the grid on screen
+        int gridIndex = loadQueue[--loadQueueCount];
+        pthread_mutex_unlock(&loadQueueLock);
+
+        for (int j = 0; j < scriptsPerGrid; j++) {
+            Script* script = FindScript(gridIndex * scriptsPerGrid + j + 1);
+            if (!script) {
+                continue;  // no file in this cell
+            }
+            pthread_mutex_lock(&scriptTextLock);
+            bool needed = !script->textLoaded && ScriptFileExists(script);
+            if (script->textLoaded) {
+                TouchScriptText(script);  // on screen again, keep it cached
+            }
+            pthread_mutex_unlock(&scriptTextLock);
+            if (needed) {
+                LoadScriptText(script);
             }
         }
     }
+    return NULL;
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // -j N limits how many scripts may run at once,
+    // -w N keeps N Python interpreters warm for running .py scripts,
+    // -g COLSxROWS sets the grid size (script numbers follow the layout),
+    // --build-all compiles every C script without opening a window,
+    // -t SECONDS kills runs that take longer, -c SECONDS and -m MB limit
+    // each run's CPU time and memory, --run RANGES [--report FILE] runs
+    // scripts or grids without a window and writes a JSON report,
+    // --pack / --unpack / --compact-pack manage gameFiles/scripts.pack,
+    // --pipeline 3,7,12 pipes those scripts into each other headless,
+    // --map FILE reads the character map for encoded scripts from FILE
+    bool buildAll = false;
+    int packCommand = 0;
+    const char* runSpec = NULL;
+    const char* pipelineSpec = NULL;
+    const char* reportPath = BATCH_REPORT_PATH;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--build-all") == 0) {
+            buildAll = true;
+        }
+        if (strcmp(argv[i], "--pack") == 0) {
+            packCommand = 1;
+        }
+        if (strcmp(argv[i], "--unpack") == 0) {
+            packCommand = 2;
+        }
+        if (strcmp(argv[i], "--compact-pack") == 0) {
+            packCommand = 3;
+        }
+        if (strcmp(argv[i], "--pipeline") == 0 && i + 1 < argc) {
+            pipelineSpec = argv[++i];
+        }
+        if (strcmp(argv[i], "--run") == 0 && i + 1 < argc) {
+            runSpec = argv[++i];
+        }
+        if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            reportPath = argv[++i];
+        }
+        if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+            charMapPath = argv[++i];
+        }
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%dx%d", &gridCols, &gridRows) != 2 ||
+                    gridCols < 1 || gridRows < 1 || gridCols > MAX_GRID_SIDE || gridRows > MAX_GRID_SIDE) {
+                printf("Grid size must be COLSxROWS, each 1 to %d.\n", MAX_GRID_SIDE);
+                return 1;
+            }
+            scriptsPerGrid = gridCols * gridRows;
+        }
+        if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            pythonWorkers = atoi(argv[++i]);
+            if (pythonWorkers < 0) {
+                pythonWorkers = 0;
+            } else if (pythonWorkers > MAX_PYTHON_WORKERS) {
+                pythonWorkers = MAX_PYTHON_WORKERS;
+            }
+        }
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            runTimeout = atof(argv[++i]);
+        }
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            cpuLimitSeconds = atoi(argv[++i]);
+        }
+        if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            memoryLimitMb = atoi(argv[++i]);
+        }
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            maxRunningProcesses = atoi(argv[++i]);
+            if (maxRunningProcesses < 1) {
+                maxRunningProcesses = 1;
+            } else if (maxRunningProcesses > MAX_PROCESS_LIMIT) {
+                maxRunningProcesses = MAX_PROCESS_LIMIT;
+            }
+        }
+    }
+
+    // Warm workers run scripts inside a long-lived interpreter, where -t,
+    // -c and -m cannot be applied per run and usage cannot be measured per
+    // run, so every script gets its own process while any of them is set
+    if (pythonWorkers > 0 && (runTimeout > 0 || cpuLimitSeconds > 0 || memoryLimitMb > 0)) {
+        printf("-w is ignored while -t, -c or -m is set, so every run is limited and measured.\n");
+        pythonWorkers = 0;
+    }
+
+#ifndef _WIN32
+    // Captured Python output should arrive as it is printed
+    setenv("PYTHONUNBUFFERED", "1", 1);
+    // A warm worker dying mid-request must not take the app down with it
+    signal(SIGPIPE, SIG_IGN);
+#endif
+
+    if (packCommand == 1) {
+        return PackGameFiles();
+    } else if (packCommand == 2) {
+        return UnpackGameFiles();
+    } else if (packCommand == 3) {
+        return CompactScriptPack();
+    }
+    if (buildAll) {
+        return BuildAllHeadless();
+    }
+#ifndef __linux__
+    if (cpuLimitSeconds > 0 || memoryLimitMb > 0) {
+        printf("CPU and memory limits need Linux and will be ignored.\n");
+    }
+#endif
+#ifdef _WIN32
+    if (runTimeout > 0) {
+        printf("The run timeout is not available on Windows and will be ignored.\n");
+    }
+#endif
+    if (runSpec) {
+        return RunBatchHeadless(runSpec, reportPath);
+    }
+    if (pipelineSpec) {
+        return RunPipelineHeadless(pipelineSpec);
+    }
+
     // Set the window to be resizable
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
 
     // Initialize window
-    InitWindow(800, 600, "Script Editor - press h for Help Menu");
+    InitWindow(800, 760, "Script Editor - press h for Help Menu");
     MaximizeWindow();  // Maximize window on startup
     SetTargetFPS(60);
 
@@ -319,112 +5349,218 @@ int main() {
 
     // Initialize grids and scripts
     InitializeAndLoadExistingScripts();
+    LoadRunHistory();
+    StartFileWatcher();
+    StartScriptLoader();
+    RequestGridLoad(currentGridIndex);
+    StartSearchIndexer();
+    StartCompileWorkers();
+    StartProcessPool();
+    StartPythonWorkers();
 
-    // Main game loop
+    // Main game loop. Frames are drawn at the target rate while anything
+    // changes and for IDLE_DELAY_SECONDS after; then the loop only polls
+    // input and sleeps until a key, the mouse, gameFiles/ or a job wakes it.
+    double lastActivity = GetTime();
     while (!WindowShouldClose()) {
+        double frameStart = NowSeconds();
+
+        // Pick up external edits in gameFiles/ and finished compiles
+        // before handling this frame
+        bool changed = atomic_exchange(&uiChanged, false);
+        changed = PollFileWatcher() || changed;
+        changed = PollCompileJobs() || changed;
+        changed = PollPipeline() || changed;
+        changed = PumpScriptOutput() || changed;
+        changed = InputActivity() || changed;
+        if (changed) {
+            lastActivity = GetTime();
+        }
+
         Vector2 mousePosition = GetMousePosition();
         int screenWidth = GetScreenWidth();
         int screenHeight = GetScreenHeight();
 
+        // '/' or Ctrl+F opens the search box; while it is open, typing goes
+        // to the query instead of the single-key shortcuts
+        bool editing = editor.open;
+        bool typing = searchActive || editing;
+        if (editing) {
+            HandleEditorInput(screenHeight);
+        } else if (!searchActive && (IsKeyPressed(KEY_SLASH) ||
+                ((IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL)) && IsKeyPressed(KEY_F)))) {
+            searchActive = true;
+            SetExitKey(KEY_NULL);  // Esc closes the box instead of the window
+            RunSearch();
+        } else if (searchActive) {
+            HandleSearchInput();
+        }
+
         // Handle grid navigation with arrow keys
-        if (IsKeyPressed(KEY_RIGHT)) {
-            SwitchGrid((currentGridIndex + 1) % MAX_GRIDS);
+        if (!editing && IsKeyPressed(KEY_RIGHT)) {
+            SwitchGrid((currentGridIndex + 1) % gridCount);
+        }
+        if (!editing && IsKeyPressed(KEY_LEFT)) {
+            SwitchGrid((currentGridIndex - 1 + gridCount) % gridCount);
+        }
+
+        // Profiler overlay and trace
+        if (IsKeyPressed(KEY_F3)) {
+            showProfiler = !showProfiler;
         }
-        if (IsKeyPressed(KEY_LEFT)) {
-            SwitchGrid((currentGridIndex - 1 + MAX_GRIDS) % MAX_GRIDS);
+        if (IsKeyPressed(KEY_F4)) {
+            if (WriteProfileTrace(PROFILE_TRACE_PATH, PROFILE_TRACE_SECONDS)) {
+                printf("Wrote the last %d s of frames to %s\n", PROFILE_TRACE_SECONDS, PROFILE_TRACE_PATH);
+            } else {
+                printf("Error: could not write %s\n", PROFILE_TRACE_PATH);
+            }
         }
 
         // Toggle Python/C mode
-        if (IsKeyPressed(KEY_ONE)) {
+        if (!typing && IsKeyPressed(KEY_ONE)) {
             ToggleScriptMode();  // Switch between Python and C grids
         }
 
         // Toggle Edit/Execute mode
-        if (IsKeyPressed(KEY_TWO)) {
+        if (!typing && IsKeyPressed(KEY_TWO)) {
             ToggleEditMode();
         }
 
         // Toggle Help Menu
-        if (IsKeyPressed(KEY_H)) {
+        if (!typing && IsKeyPressed(KEY_H)) {
             showHelpMenu = !showHelpMenu;
         }
 
+        // Run the Ctrl+clicked scripts as a pipeline
+        if (!typing && IsKeyPressed(KEY_P) && StartPipeline(pipelineDraft.stages, pipelineDraft.stageCount, false)) {
+            pipelineDraft.stageCount = 0;
+        }
+
+        // Build every C script of this grid, or of all grids with Shift
+        if (!typing && IsKeyPressed(KEY_B)) {
+            bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+            BuildAllScripts(shift ? -1 : currentGridIndex);
+        }
+
+        // Scroll the grid with the wheel (Shift for sideways), zoom with
+        // Ctrl+wheel or +/-, pan with the middle button, Home resets the view
+        bool overGrid = !editing && CheckCollisionPointRec(mousePosition, gridView);
+        float wheel = overGrid ? GetMouseWheelMove() : 0;
+        bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+        if (wheel != 0 && control) {
+            ZoomGridView(wheel > 0 ? 1.25f : 0.8f, mousePosition);
+        } else if (wheel != 0 && (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT))) {
+            targetScroll.x -= wheel * BUTTON_SIZE * zoom;
+        } else if (wheel != 0) {
+            targetScroll.y -= wheel * BUTTON_SIZE * zoom;
+        }
+        if (!typing && (IsKeyPressed(KEY_EQUAL) || IsKeyPressed(KEY_KP_ADD))) {
+            ZoomGridView(1.25f, (Vector2){ gridView.x + gridView.width / 2, gridView.y + gridView.height / 2 });
+        }
+        if (!typing && (IsKeyPressed(KEY_MINUS) || IsKeyPressed(KEY_KP_SUBTRACT))) {
+            ZoomGridView(0.8f, (Vector2){ gridView.x + gridView.width / 2, gridView.y + gridView.height / 2 });
+        }
+        if (!editing && IsKeyPressed(KEY_UP)) {
+            targetScroll.y -= BUTTON_SIZE * zoom;
+        }
+        if (!editing && IsKeyPressed(KEY_DOWN)) {
+            targetScroll.y += BUTTON_SIZE * zoom;
+        }
+        if (IsMouseButtonDown(MOUSE_BUTTON_MIDDLE) && overGrid) {
+            Vector2 delta = GetMouseDelta();
+            targetScroll.x -= delta.x;
+            targetScroll.y -= delta.y;
+            scroll = targetScroll;
+        }
+        if (!typing && IsKeyPressed(KEY_HOME)) {
+            ZoomGridView(1.0f / zoom, (Vector2){ gridView.x, gridView.y });
+            targetScroll = (Vector2){ 0, 0 };
+        }
+        if (UpdateGridView(screenWidth, screenHeight)) {
+            lastActivity = GetTime();  // keep drawing until the scroll settles
+        }
+
         // Check for button clicks to create or edit scripts
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
-            int xIndex = mousePosition.x / BUTTON_SIZE;
-            int yIndex = mousePosition.y / BUTTON_SIZE;
-            int index = yIndex * GRID_COLS + xIndex;
-
-            if (xIndex < GRID_COLS && yIndex < GRID_ROWS) {
-                if (index < MAX_SCRIPTS) {
-                    selectedScriptIndex = index;
-                    
-                    // Check if the script exists in the opposite mode
-                    char altFilename[100];
-                    if (isCFile) {
-                        snprintf(altFilename, sizeof(altFilename), GAME_FILES_PATH "script%d.py", 
-                                currentGridIndex * MAX_SCRIPTS + index + 1);
-                    } else {
-                        snprintf(altFilename, sizeof(altFilename), GAME_FILES_PATH "script%d.c", 
-                                currentGridIndex * MAX_SCRIPTS + index + 1);
-                    }
-                    
-                    // If the current mode script doesn't exist but the opposite does
-                    if (!DoesFileExist(grids[currentGridIndex].scripts[index].filename) && DoesFileExist(altFilename)) {
-                        // Update the filename to use the existing script but maintain the current mode setting
-                        strcpy(grids[currentGridIndex].scripts[index].filename, altFilename);
-                        grids[currentGridIndex].scripts[index].isCFile = !isCFile;
-                    }
-                    
-                    if (!DoesFileExist(grids[currentGridIndex].scripts[index].filename)) {
-                        CreateNewScript(currentGridIndex, index);
-                    } else if (isEditingMode) {
-                        // Only open in Notepad if in editing mode
-                        grids[currentGridIndex].scripts[index].isEditing = true;
-                        OpenScriptInNotepad(grids[currentGridIndex].scripts[index].filename);
+        if (!editing && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+            int index = CellAt(mousePosition);
+
+            if (index >= 0 && control) {
+                // Ctrl+click chains existing scripts into a pipeline instead
+                Script* script = GetGridScript(currentGridIndex, index);
+                if (ScriptFileExists(script)) {
+                    TogglePipelineStage(script->number);
+                }
+            } else if (index >= 0) {
+                selectedScriptIndex = index;
+                Script* script = GetGridScript(currentGridIndex, index);
+                
+                // Check if the script exists in the opposite mode
+                unsigned char altFlag = isCFile ? STATUS_PY : STATUS_C;
+                char altFilename[100];
+                if (isCFile) {
+                    snprintf(altFilename, sizeof(altFilename), GAME_FILES_PATH "script%d.py", script->number);
+                } else {
+                    snprintf(altFilename, sizeof(altFilename), GAME_FILES_PATH "script%d.c", script->number);
+                }
+                
+                // If the current mode script doesn't exist but the opposite does
+                if (!ScriptFileExists(script) && (script->status.flags & altFlag)) {
+                    // Update the filename to use the existing script but maintain the current mode setting
+                    pthread_mutex_lock(&scriptTextLock);
+                    strcpy(script->filename, altFilename);
+                    script->isCFile = !isCFile;
+                    pthread_mutex_unlock(&scriptTextLock);
+                }
+                
+                if (!ScriptFileExists(script)) {
+                    CreateNewScript(currentGridIndex, index);
+                } else if (isEditingMode && (IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT))) {
+                    // Shift+click still opens the external editor
+                    script->isEditing = true;
+                    OpenScriptInNotepad(script->filename);
+                } else if (isEditingMode) {
+                    OpenEditor(script->filename, script->number);
+                } else {
+                    // If in execution mode, run the script
+                    if (script->isCFile) {
+                        CompileAndExecuteCFile(script->filename);
                     } else {
-                        // If in execution mode, run the script
-                        if (grids[currentGridIndex].scripts[index].isCFile) {
-                            CompileAndExecuteCFile(grids[currentGridIndex].scripts[index].filename);
-                        } else {
-                            ExecutePythonScript(grids[currentGridIndex].scripts[index].filename);
-                        }
+                        ExecutePythonScript(script->filename);
                     }
                 }
             }
         }
 
         // Handle right-click to create a description file
-        if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
-            int xIndex = mousePosition.x / BUTTON_SIZE;
-            int yIndex = mousePosition.y / BUTTON_SIZE;
-            int index = yIndex * GRID_COLS + xIndex;
-
-            if (xIndex < GRID_COLS && yIndex < GRID_ROWS && index < MAX_SCRIPTS) {
-                if (DoesFileExist(grids[currentGridIndex].scripts[index].filename)) {
-                    CreateDescriptionFile(grids[currentGridIndex].scripts[index].filename);
+        if (!editing && IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
+            int index = CellAt(mousePosition);
+
+            if (index >= 0) {
+                Script* script = GetGridScript(currentGridIndex, index);
+                if (ScriptFileExists(script)) {
+                    CreateDescriptionFile(script->filename);
                 } else {
                     // Create the script first if it doesn't exist
                     CreateNewScript(currentGridIndex, index);
-                    CreateDescriptionFile(grids[currentGridIndex].scripts[index].filename);
+                    CreateDescriptionFile(script->filename);
                 }
             }
         }
 
         // Handle keyboard shortcuts for selected script
         if (selectedScriptIndex != -1) {
-            Script* currentScript = &grids[currentGridIndex].scripts[selectedScriptIndex];
+            Script* currentScript = GetGridScript(currentGridIndex, selectedScriptIndex);
             
             // Handle reload - refresh script content from file
-            if (IsKeyPressed(KEY_R)) {
-                if (DoesFileExist(currentScript->filename)) {
-                    LoadScriptFromFile(currentScript->filename, currentScript->text, MAX_TEXT_LENGTH);
+            if (!typing && IsKeyPressed(KEY_R)) {
+                if (ScriptFileExists(currentScript)) {
+                    LoadScriptText(currentScript);
                 }
             }
             
             // Execute script with E key
-            if (IsKeyPressed(KEY_E)) {
-                if (DoesFileExist(currentScript->filename)) {
+            if (!typing && IsKeyPressed(KEY_E)) {
+                if (ScriptFileExists(currentScript)) {
                     if (currentScript->isCFile) {
                         CompileAndExecuteCFile(currentScript->filename);
                     } else {
@@ -432,89 +5568,82 @@ int main() {
                     }
                 }
             }
+
+            // Scroll the console with PageUp/PageDown or the wheel over it
+            if (!editing && currentScript->console) {
+                int wheel = 0;
+                if (mousePosition.y > gridView.y + gridView.height && mousePosition.y < screenHeight - 30) {
+                    wheel = (int)(GetMouseWheelMove() * 3);
+                }
+                if (IsKeyPressed(KEY_PAGE_UP)) {
+                    wheel += 10;
+                }
+                if (IsKeyPressed(KEY_PAGE_DOWN)) {
+                    wheel -= 10;
+                }
+                currentScript->console->scroll += wheel;
+                if (currentScript->console->scroll < 0) {
+                    currentScript->console->scroll = 0;
+                }
+            }
+        }
+
+        // Idle: nothing on screen can have changed, skip the frame
+        if (GetTime() - lastActivity > IDLE_DELAY_SECONDS) {
+            WaitForActivity(IDLE_WAIT_MS);
+            PollInputEvents();
+            continue;
         }
 
         // Draw grid and UI
+        double logicEnd = NowSeconds();
         BeginDrawing();
         ClearBackground(RAYWHITE);
 
         if (showHelpMenu) {
             DrawHelpMenu();  // Draw help menu if the flag is set
+        } else if (editor.open) {
+            DrawEditor(screenWidth, screenHeight);
         } else {
             // Draw grid title and ID
             DrawText(TextFormat("Grid ID: %d", currentGridIndex + 1), 10, 10, 20, DARKGRAY);
+            if (buildBatchActive) {
+                DrawText(TextFormat("Building %d/%d", buildResultCount, buildBatchTotal), 150, 10, 20, ORANGE);
+            } else if (buildResultCount > 0) {
+                DrawText(TextFormat("Built %d, %d failed", buildResultCount, buildBatchFailed), 150, 10, 20,
+                        buildBatchFailed > 0 ? RED : DARKGREEN);
+            }
             
-            // Draw script buttons
-            for (int y = 0; y < GRID_ROWS; y++) {
-                for (int x = 0; x < GRID_COLS; x++) {
-                    int index = y * GRID_COLS + x;
-                    Rectangle button = { x * BUTTON_SIZE, y * BUTTON_SIZE, BUTTON_SIZE, BUTTON_SIZE };
-                    
-                    // Default button color is light gray
-                    Color buttonColor = LIGHTGRAY; 
-                    Color textColor = DARKGRAY;
-
-                    Script* script = &grids[currentGridIndex].scripts[index];
-                    
-                    // Determine button color based on script status
-                    if (DoesFileExist(script->filename)) {
-                        if (script->isCFile) {
-                            buttonColor = YELLOW;  // Yellow for C scripts
-                        } else {
-                            buttonColor = PURPLE;  // Purple for Python scripts
-                        }
-                        
-                        // Add different shade for currently selected script
-                        if (index == selectedScriptIndex) {
-                            buttonColor = ColorBrightness(buttonColor, 0.7f);  // Brighten the color
-                            textColor = BLACK;  // Make text more visible
-                        }
-                    } else if (index == selectedScriptIndex) {
-                        buttonColor = ORANGE;  // Orange for selected but non-existent script
-                    }
-
-                    // Draw button with the determined color
-                    DrawRectangleRec(button, buttonColor);
-                    DrawRectangleLinesEx(button, 2, DARKGRAY);
-
-                    // Draw script number and status
-                    int scriptNumber = currentGridIndex * MAX_SCRIPTS + index + 1;
-                    
-                    // Draw script indicator
-                    if (DoesFileExist(script->filename)) {
-                        char fileTypeIndicator[2];
-                        if (script->isCFile) {
-                            fileTypeIndicator[0] = 'C';
-                        } else {
-                            fileTypeIndicator[0] = 'P';  // Python
-                        }
-                        fileTypeIndicator[1] = '\0';
-                        
-                        DrawText(fileTypeIndicator, button.x + BUTTON_SIZE - 20, button.y + 5, 20, textColor);
+            // Draw script buttons from the cached layer, then what changes
+            // every frame: the selected button and job status
+            DrawGridLayer();
+            BeginScissorMode(gridView.x, gridView.y, gridView.width, gridView.height);
+            if (selectedScriptIndex != -1) {
+                DrawScriptButton(selectedScriptIndex, true);
+            }
+            int firstCol, lastCol, firstRow, lastRow;
+            GetVisibleCells(&firstCol, &lastCol, &firstRow, &lastRow);
+            for (int row = firstRow; row <= lastRow; row++) {
+                for (int col = firstCol; col <= lastCol; col++) {
+                    DrawScriptStatus(row * gridCols + col);
+                    if (searchActive && IsSearchMatch(currentGridIndex * scriptsPerGrid + row * gridCols + col + 1)) {
+                        DrawRectangleLinesEx(CellRect(row * gridCols + col), 3, BLUE);
                     }
-                    
-                    // Draw script number
-                    DrawText(TextFormat("%d", scriptNumber), button.x + 5, button.y + 5, 20, textColor);
-                    
-                    // Draw script name or status
-                    if (index == selectedScriptIndex && script->isEditing) {
-                        DrawText("Editing...", button.x + 5, button.y + BUTTON_SIZE - 25, 20, textColor);
-                    } else if (DoesFileExist(script->filename)) {
-                        // Show abbreviated filename (just the number part)
-                        char* lastSlash = strrchr(script->filename, '/');
-                        if (lastSlash) {
-                            DrawText(lastSlash + 1, button.x + 5, button.y + BUTTON_SIZE - 25, 16, textColor);
-                        } else {
-                            DrawText(script->filename, button.x + 5, button.y + BUTTON_SIZE - 25, 16, textColor);
-                        }
+                    int stage = PipelineStageOf(currentGridIndex * scriptsPerGrid + row * gridCols + col + 1);
+                    if (stage >= 0) {
+                        Rectangle cell = CellRect(row * gridCols + col);
+                        DrawRectangleLinesEx(cell, 3, MAROON);
+                        DrawText(TextFormat("%d", stage + 1), cell.x + cell.width - 18 * zoom, cell.y + cell.height - 24 * zoom,
+                                (int)(20 * zoom), MAROON);
                     }
                 }
             }
+            EndScissorMode();
 
             // Draw feedback panel in the top right corner
             int panelX = screenWidth - 200;
             int panelY = 10;
-            DrawRectangle(panelX - 10, panelY - 10, 190, 190, LIGHTGRAY);  // Panel background
+            DrawRectangle(panelX - 10, panelY - 10, 190, 210, LIGHTGRAY);  // Panel background
             DrawText("FEEDBACK PANEL", panelX, panelY, 20, DARKGRAY);
             DrawText(TextFormat("Current Grid: %d", currentGridIndex + 1), panelX, panelY + 30, 20, DARKGRAY);
 
@@ -540,7 +5669,7 @@ int main() {
 
             // Draw selected script info
             if (selectedScriptIndex != -1) {
-                Script* selectedScript = &grids[currentGridIndex].scripts[selectedScriptIndex];
+                Script* selectedScript = GetGridScript(currentGridIndex, selectedScriptIndex);
                 
                 DrawText("Selected Script:", panelX, panelY + 130, 16, DARKGRAY);
                 
@@ -551,22 +5680,46 @@ int main() {
                 
                 DrawText(displayName, panelX, panelY + 150, 16, BLUE);
                 
-                if (DoesFileExist(selectedScript->filename)) {
+                if (ScriptFileExists(selectedScript)) {
                     DrawText("File Status: Exists", panelX, panelY + 170, 16, GREEN);
                 } else {
                     DrawText("File Status: Not Created", panelX, panelY + 170, 16, RED);
                 }
+
+                // First line of the last failed compile of this script
+                if (selectedScript->compileState == COMPILE_FAILED && lastCompileErrorScript == selectedScript->number) {
+                    DrawText(lastCompileError, panelX, panelY + 190, 10, RED);
+                }
             }
             
-            // Draw keyboard shortcut help at the bottom
-            DrawRectangle(0, screenHeight - 30, screenWidth, 30, LIGHTGRAY);
-            DrawText("KEYBOARD: [H]elp [1]Toggle Mode [2]Toggle Edit/Execute [E]xecute [R]eload [LEFT/RIGHT] Change Grid", 
-                    10, screenHeight - 25, 20, DARKGRAY);
+            // Output of the selected script below the grid
+            if (selectedScriptIndex != -1) {
+                int consoleY = gridView.y + gridView.height + 5;
+                DrawConsolePanel(GetGridScript(currentGridIndex, selectedScriptIndex),
+                        0, consoleY, screenWidth, screenHeight - 35 - consoleY);
+            }
+
+            // Draw keyboard shortcut help (or the search box) at the bottom
+            if (searchActive) {
+                DrawSearchBar(screenWidth, screenHeight);
+            } else {
+                DrawRectangle(0, screenHeight - 30, screenWidth, 30, LIGHTGRAY);
+                DrawText("KEYBOARD: [H]elp [1]Toggle Mode [2]Toggle Edit/Execute [E]xecute [R]eload [B]uild All [P]ipeline [LEFT/RIGHT] Change Grid [/] Search", 
+                        10, screenHeight - 25, 20, DARKGRAY);
+            }
+        }
+        if (showProfiler) {
+            DrawProfilerHud(screenWidth);
         }
 
+        double drawEnd = NowSeconds();
         EndDrawing();
+        ProfileFrame(frameStart, logicEnd, drawEnd, NowSeconds());
     }
 
+    if (gridTextureReady) {
+        UnloadRenderTexture(gridTexture);
+    }
     CloseWindow();
     return 0;
 }
\ No newline at end of file
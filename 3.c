@@ -16,6 +16,7 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <math.h>
+#include "registry.h"
 
 #define MAX_CHAR_MAP 256
 #define MAX_FILENAME 256
@@ -65,6 +66,9 @@ typedef struct {
     GtkWidget *decode_input_preview;
     GtkWidget *decode_output_preview;
     
+    // Roles and paths of the numbered files, from 0.txt
+    Registry *registry;
+    
     // Character mapping data
     char *char_map[MAX_CHAR_MAP];
     int char_map_size;
@@ -96,6 +100,7 @@ static void apply_color_tags_to_charmap(AppData *app);
 static void set_status_message(AppData *app, const char *message);
 static void set_progress_value(AppData *app, double progress);
 static gboolean load_file_content(const char *filename, char *buffer, size_t buffer_size);
+static char *read_input_text(AppData *app, int file_number, const char *filename);
 static void show_message_dialog(GtkWindow *parent, const char *message, GtkMessageType type);
 static GtkWidget* create_matrix_header(AppData *app);
 static GtkWidget* create_styled_button(const char *label, GCallback callback, AppData *app);
@@ -110,6 +115,8 @@ int main(int argc, char *argv[]) {
     AppData app;
     memset(&app, 0, sizeof(AppData));
     
+    app.registry = registry_open(".");
+    
     // Initialize character mapping
     app.char_map_size = 0;
     app.is_map_loaded = false;
@@ -144,6 +151,7 @@ int main(int argc, char *argv[]) {
     for (int i = 0; i < app.char_map_size; i++) {
         free(app.char_map[i]);
     }
+    registry_close(app.registry);
     
     return 0;
 }
@@ -878,7 +886,7 @@ static void load_char_map(GtkWidget *widget, AppData *app) {
         }
         
         if (is_number) {
-            snprintf(filename, sizeof(filename), "%s.txt", file_input);
+            registry_path(app->registry, atoi(file_input), filename, sizeof(filename));
         } else {
             strncpy(filename, file_input, sizeof(filename)-1);
             filename[sizeof(filename)-1] = '\0';
@@ -890,9 +898,9 @@ static void load_char_map(GtkWidget *widget, AppData *app) {
     
     set_status_message(app, "LOADING CHARACTER MAP...");
     
-    // Open the file
-    FILE *file = fopen(filename, "r");
-    if (!file) {
+    // Read the file; numbered files may be sharded, packed or chunked
+    char *text = read_input_text(app, registry_parse_number(file_input), filename);
+    if (!text) {
         show_message_dialog(GTK_WINDOW(app->window), 
                            "Failed to open character map file", 
                            GTK_MESSAGE_ERROR);
@@ -920,8 +928,9 @@ static void load_char_map(GtkWidget *widget, AppData *app) {
     // Read and process each line
     char line[MAX_LINE_LENGTH];
     int line_num = 0;
+    const char *cursor = text;
     
-    while (fgets(line, sizeof(line), file)) {
+    while (registry_gets(line, sizeof(line), &cursor)) {
         line_num++;
         
         // Remove newline character
@@ -1019,7 +1028,7 @@ static void load_char_map(GtkWidget *widget, AppData *app) {
         }
     }
     
-    fclose(file);
+    free(text);
     
     // Update progress
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 0.6);
@@ -1123,7 +1132,7 @@ static void encode_file(GtkWidget *widget, AppData *app) {
     while (gtk_events_pending()) gtk_main_iteration();
     
     char output_filename[MAX_FILENAME];
-    snprintf(output_filename, sizeof(output_filename), "%s.txt", output_file_number);
+    registry_create_path(app->registry, atoi(output_file_number), output_filename, sizeof(output_filename));
     
     // Open input file
     FILE *input_file = fopen(input_filename, "r");
@@ -1136,9 +1145,10 @@ static void encode_file(GtkWidget *widget, AppData *app) {
         return;
     }
     
-    // Open output file
-    FILE *output_file = fopen(output_filename, "w");
-    if (!output_file) {
+    // Open output file; with the chunk store on, the output is collected
+    // in encoded_content first and only its new chunks are written
+    FILE *output_file = NULL;
+    if (!app->registry->deduplicated && !(output_file = fopen(output_filename, "w"))) {
         fclose(input_file);
         show_message_dialog(GTK_WINDOW(app->window), 
                            "Could not open output file", 
@@ -1161,22 +1171,46 @@ static void encode_file(GtkWidget *widget, AppData *app) {
     set_status_message(app, "APPLYING CHARACTER MAPPING...");
     while (gtk_events_pending()) gtk_main_iteration();
     
-    // Read each character from the input file
+    // Read each character from the input file. CRLF encodes as a bare
+    // newline, as text mode reads it on Windows, so a source encodes the
+    // same on every system.
     int c;
     while ((c = fgetc(input_file)) != EOF) {
+        if (c == '\r') {
+            int next = fgetc(input_file);
+            if (next == '\n') {
+                c = next;
+            } else if (next != EOF) {
+                ungetc(next, input_file);
+            }
+        }
         int index = find_char_index(app, (char)c);
         if (index != -1) {
             g_string_append_printf(encoded_content, "%d ", index);
-            fprintf(output_file, "%d ", index);
         } else {
             // For characters not in our mapping, use 0
             g_string_append(encoded_content, "0 ");
-            fprintf(output_file, "0 ");
         }
     }
     
     fclose(input_file);
-    fclose(output_file);
+    gboolean written;
+    if (output_file) {
+        written = fwrite(encoded_content->str, 1, encoded_content->len, output_file) == encoded_content->len;
+        written = fclose(output_file) == 0 && written;
+    } else {
+        written = registry_store(app->registry, atoi(output_file_number), encoded_content->str, encoded_content->len);
+    }
+    registry_invalidate(app->registry, registry_parse_number(output_file_number));
+    if (!written) {
+        g_string_free(encoded_content, TRUE);
+        show_message_dialog(GTK_WINDOW(app->window), 
+                           "Could not write output file", 
+                           GTK_MESSAGE_ERROR);
+        gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 0.0);
+        set_status_message(app, "ERROR: Failed to write output file");
+        return;
+    }
     
     // Update progress
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 0.8);
@@ -1230,6 +1264,16 @@ static void decode_file(GtkWidget *widget, AppData *app) {
         return;
     }
     
+    // An encoded file listed in 0.txt decodes to its registered
+    // counterpart unless another output number is given
+    char pair_number[16];
+    int pair = registry_pair(app->registry, registry_parse_number(input_file_number));
+    if (strlen(output_file_number) == 0 && pair >= 0) {
+        snprintf(pair_number, sizeof(pair_number), "%d", pair);
+        output_file_number = pair_number;
+        gtk_entry_set_text(GTK_ENTRY(app->decode_output_entry), pair_number);
+    }
+    
     if (strlen(output_file_number) == 0) {
         show_message_dialog(GTK_WINDOW(app->window), 
                            "Please enter an output file number", 
@@ -1253,23 +1297,27 @@ static void decode_file(GtkWidget *widget, AppData *app) {
     }
     
     if (is_number) {
-        snprintf(input_filename, sizeof(input_filename), "%s.txt", input_file_number);
+        registry_path(app->registry, atoi(input_file_number), input_filename, sizeof(input_filename));
     } else {
         strncpy(input_filename, input_file_number, sizeof(input_filename)-1);
         input_filename[sizeof(input_filename)-1] = '\0';
     }
     
     char output_filename[MAX_FILENAME];
-    snprintf(output_filename, sizeof(output_filename), "%s.txt", output_file_number);
+    if (registry_parse_number(output_file_number) >= 0) {
+        registry_create_path(app->registry, atoi(output_file_number), output_filename, sizeof(output_filename));
+    } else {
+        snprintf(output_filename, sizeof(output_filename), "%s.txt", output_file_number);
+    }
     
     // Update progress
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 0.2);
     set_status_message(app, "READING ENCODED DATA...");
     while (gtk_events_pending()) gtk_main_iteration();
     
-    // Open input file
-    FILE *input_file = fopen(input_filename, "r");
-    if (!input_file) {
+    // Read input file; numbered files may be sharded, packed or chunked
+    char *input_text = read_input_text(app, is_number ? atoi(input_file_number) : -1, input_filename);
+    if (!input_text) {
         show_message_dialog(GTK_WINDOW(app->window), 
                            "Could not open input file", 
                            GTK_MESSAGE_ERROR);
@@ -1281,7 +1329,7 @@ static void decode_file(GtkWidget *widget, AppData *app) {
     // Open output file
     FILE *output_file = fopen(output_filename, "w");
     if (!output_file) {
-        fclose(input_file);
+        free(input_text);
         show_message_dialog(GTK_WINDOW(app->window), 
                            "Could not open output file", 
                            GTK_MESSAGE_ERROR);
@@ -1304,8 +1352,11 @@ static void decode_file(GtkWidget *widget, AppData *app) {
     while (gtk_events_pending()) gtk_main_iteration();
     
     // Read each number from the input file
-    int index;
-    while (fscanf(input_file, "%d", &index) == 1) {
+    const char *cursor = input_text;
+    char *end;
+    long index;
+    while ((index = strtol(cursor, &end, 10)), end != cursor) {
+        cursor = end;
         if (index > 0 && index <= app->char_map_size && app->char_map[index - 1] != NULL) {
             g_string_append(decoded_content, app->char_map[index - 1]);
             fprintf(output_file, "%s", app->char_map[index - 1]);
@@ -1316,8 +1367,9 @@ static void decode_file(GtkWidget *widget, AppData *app) {
         }
     }
     
-    fclose(input_file);
+    free(input_text);
     fclose(output_file);
+    registry_invalidate(app->registry, registry_parse_number(output_file_number));
     
     // Update progress
     gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(app->progress_bar), 0.8);
@@ -1493,6 +1545,22 @@ static gboolean load_file_content(const char *filename, char *buffer, size_t buf
     return TRUE;
 }
 
+// Whole text of an input file in a buffer to free(): numbered files (a
+// file_number of 0 or more) through the registry, anything else directly.
+// NULL if it cannot be read.
+static char *read_input_text(AppData *app, int file_number, const char *filename) {
+    if (file_number >= 0) {
+        return registry_read(app->registry, file_number, NULL);
+    }
+    gchar *contents;
+    if (!g_file_get_contents(filename, &contents, NULL, NULL)) {
+        return NULL;
+    }
+    char *text = strdup(contents);
+    g_free(contents);
+    return text;
+}
+
 // Show a message dialog
 static void show_message_dialog(GtkWindow *parent, const char *message, GtkMessageType type) {
     GtkWidget *dialog = gtk_message_dialog_new(
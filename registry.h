@@ -0,0 +1,1168 @@
+// Registry of the numbered .txt file system described in 0.txt, shared by
+// 0.c, 2.c and 3.c (0.py has the same thing in registry.py).
+//
+// 0.txt lists each file system as "N<tab>(.ext file system){", then one
+// "id<tab>role" line per numbered file and a closing "}". Only the .txt
+// system is loaded. The table is indexed by id, so looking up a role or
+// the encoded/decoded partner of a file is one array access, and file
+// metadata is cached so that batch jobs stat each file at most once.
+//
+// Large stores can switch to a sharded layout (an empty ".sharded" file in
+// the directory), where N.txt lives in ab/cd/N.txt with ab and cd taken
+// from a hash of N, so no directory grows past a few thousand entries.
+// Small files can also be bundled into packs/K.pack, which holds ids
+// K * REGISTRY_PACK_SPAN up to the next pack behind a fixed-size table of
+// contents. Either way a lookup is a path computation plus at most one
+// table read, however many files there are.
+//
+// With a ".deduplicated" file in the directory, encoded output is stored
+// by content: it is cut into chunks where a rolling hash of the last 64
+// bytes hits a pattern, so an edit only changes the chunks around it, and
+// each chunk is kept once in chunks/ab/<sha256>. N.txt is then a manifest
+// listing its chunks, and re-encoding a lightly modified file writes only
+// the chunks that changed plus a new manifest.
+//
+// Every tool is a single .c file, so the functions are defined here;
+// include this header from one .c file per program.
+#ifndef REGISTRY_H
+#define REGISTRY_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <stdint.h>
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+#define REGISTRY_FILE "0.txt"
+#define REGISTRY_EXTENSION ".txt"
+#define REGISTRY_ROLE_LENGTH 128
+#define REGISTRY_PATH_LENGTH 256
+#define REGISTRY_NAME_LENGTH 160  // longest name joined onto the directory
+#define REGISTRY_FULL_PATH_LENGTH (REGISTRY_PATH_LENGTH + REGISTRY_NAME_LENGTH)
+#define REGISTRY_MAX_ID 1000000  // larger ids are never cached or packed
+#define REGISTRY_SHARD_MARKER ".sharded"  // present when the ab/cd/N.txt layout is on
+#define REGISTRY_PACK_DIRECTORY "packs"
+#define REGISTRY_PACK_MAGIC "NTXPACK1"
+#define REGISTRY_PACK_SPAN 4096     // ids per pack file
+#define REGISTRY_PACK_SMALL 65536   // larger files are left loose
+#define REGISTRY_PACK_HEADER (8 + REGISTRY_PACK_SPAN * 8)  // magic, then offset and length per id
+#define REGISTRY_DEDUP_MARKER ".deduplicated"  // present when encoded output is stored by content
+#define REGISTRY_CHUNK_DIRECTORY "chunks"
+#define REGISTRY_MANIFEST_MAGIC "NTXCHUNKS1"    // first line of a manifest N.txt
+#define REGISTRY_CHUNK_MIN 2048
+#define REGISTRY_CHUNK_MAX 65536
+#define REGISTRY_CHUNK_MASK 0xfff8000000000000ull  // 13 bits: chunks average about 8 KB past the minimum
+
+typedef struct {
+    int id;
+    char role[REGISTRY_ROLE_LENGTH];  // empty if 0.txt does not list the id
+    int encoded;  // 1 encoded, 0 decoded, -1 neither
+    int pair;     // id of the other half of an encoded/decoded pair, -1 if none
+} RegistryEntry;
+
+typedef struct {
+    int known;  // metadata has been read
+    int exists;
+    long long size;
+    time_t mtime;
+} RegistryFile;
+
+// Table of contents of one pack file, little-endian on disk
+typedef struct {
+    int exists;
+    time_t mtime;
+    unsigned int offset[REGISTRY_PACK_SPAN];  // 0 if the id is not packed
+    unsigned int length[REGISTRY_PACK_SPAN];
+} RegistryPack;
+
+typedef struct {
+    char directory[REGISTRY_PATH_LENGTH];  // where 0.txt and the N.txt files are
+    RegistryEntry *entries;  // indexed by id
+    int entry_count;         // highest listed id + 1
+    RegistryFile *files;     // indexed by id, grown on demand
+    int file_count;
+    RegistryFile untracked;  // registry_stat of the last id past REGISTRY_MAX_ID
+    int scanned;             // files[] holds a full directory scan
+    int sharded;             // unlisted files use the ab/cd/N.txt layout
+    RegistryPack **packs;    // indexed by pack number, read on first use
+    int pack_count;
+    int deduplicated;        // encoders store output through registry_store
+    int stored_chunks;       // chunks in the last registry_store
+    int new_chunks;          // of which were not in the store yet
+    long long new_bytes;     // bytes those took
+} Registry;
+
+Registry *registry_open(const char *directory);
+void registry_close(Registry *registry);
+const RegistryEntry *registry_entry(const Registry *registry, int id);
+int registry_pair(const Registry *registry, int id);
+int registry_find_role(const Registry *registry, const char *text);
+int registry_parse_number(const char *text);
+const char *registry_path(const Registry *registry, int id, char *buffer, size_t size);
+const char *registry_create_path(const Registry *registry, int id, char *buffer, size_t size);
+char *registry_read(Registry *registry, int id, size_t *length);
+char *registry_gets(char *line, int size, const char **cursor);
+const RegistryFile *registry_stat(Registry *registry, int id);
+int registry_scan(Registry *registry);
+void registry_invalidate(Registry *registry, int id);
+int registry_shard(Registry *registry);
+int registry_pack(Registry *registry);
+int registry_store(Registry *registry, int id, const char *data, size_t length);
+int registry_deduplicate(Registry *registry);
+
+// Role text with its "encoded"/"decoded" word removed, to match pairs
+static void registry_pair_key(const char *role, char *key, size_t size) {
+    const char *word = strstr(role, "encoded");
+    if (!word) {
+        word = strstr(role, "decoded");
+    }
+    if (!word) {
+        snprintf(key, size, "%s", role);
+        return;
+    }
+    snprintf(key, size, "%.*s%s", (int)(word - role), role, word + 7);
+}
+
+// Parse directory/0.txt. A missing 0.txt gives an empty registry, so the
+// tools still resolve paths without it. NULL only when out of memory.
+Registry *registry_open(const char *directory) {
+    Registry *registry = calloc(1, sizeof(Registry));
+    if (!registry) {
+        return NULL;
+    }
+    snprintf(registry->directory, sizeof(registry->directory), "%s", directory ? directory : ".");
+
+    char filename[REGISTRY_FULL_PATH_LENGTH];
+    struct stat buffer;
+    snprintf(filename, sizeof(filename), "%s/" REGISTRY_SHARD_MARKER, registry->directory);
+    registry->sharded = stat(filename, &buffer) == 0;
+    snprintf(filename, sizeof(filename), "%s/" REGISTRY_DEDUP_MARKER, registry->directory);
+    registry->deduplicated = stat(filename, &buffer) == 0;
+    snprintf(filename, sizeof(filename), "%s/" REGISTRY_FILE, registry->directory);
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        return registry;
+    }
+
+    char line[REGISTRY_ROLE_LENGTH + 32];
+    int in_txt_system = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (strchr(line, '{')) {
+            in_txt_system = strstr(line, "(" REGISTRY_EXTENSION " ") != NULL;
+            continue;
+        }
+        if (line[0] == '}') {
+            in_txt_system = 0;
+            continue;
+        }
+        char *tab = strchr(line, '\t');
+        if (!in_txt_system || !tab || tab == line) {
+            continue;
+        }
+        *tab = '\0';
+        int id = registry_parse_number(line);
+        if (id < 0 || id >= REGISTRY_MAX_ID) {
+            continue;
+        }
+        if (id >= registry->entry_count) {
+            RegistryEntry *grown = realloc(registry->entries, (id + 1) * sizeof(RegistryEntry));
+            if (!grown) {
+                break;
+            }
+            memset(grown + registry->entry_count, 0, (id + 1 - registry->entry_count) * sizeof(RegistryEntry));
+            for (int i = registry->entry_count; i <= id; i++) {
+                grown[i].id = i;
+                grown[i].encoded = -1;
+                grown[i].pair = -1;
+            }
+            registry->entries = grown;
+            registry->entry_count = id + 1;
+        }
+        RegistryEntry *entry = &registry->entries[id];
+        snprintf(entry->role, sizeof(entry->role), "%s", tab + 1);
+        entry->encoded = strstr(entry->role, "encoded") ? 1 : (strstr(entry->role, "decoded") ? 0 : -1);
+    }
+    fclose(file);
+
+    // Pair each encoded file with the decoded file of the same role
+    for (int i = 0; i < registry->entry_count; i++) {
+        RegistryEntry *entry = &registry->entries[i];
+        if (entry->encoded != 1) {
+            continue;
+        }
+        char key[REGISTRY_ROLE_LENGTH];
+        registry_pair_key(entry->role, key, sizeof(key));
+        for (int j = 0; j < registry->entry_count; j++) {
+            RegistryEntry *other = &registry->entries[j];
+            char other_key[REGISTRY_ROLE_LENGTH];
+            if (other->encoded != 0 || other->pair >= 0) {
+                continue;
+            }
+            registry_pair_key(other->role, other_key, sizeof(other_key));
+            if (strcmp(key, other_key) == 0) {
+                entry->pair = j;
+                other->pair = i;
+                break;
+            }
+        }
+    }
+    return registry;
+}
+
+void registry_close(Registry *registry) {
+    if (registry) {
+        free(registry->entries);
+        free(registry->files);
+        for (int i = 0; i < registry->pack_count; i++) {
+            free(registry->packs[i]);
+        }
+        free(registry->packs);
+        free(registry);
+    }
+}
+
+// The 0.txt line for id, or NULL if it has none
+const RegistryEntry *registry_entry(const Registry *registry, int id) {
+    if (!registry || id < 0 || id >= registry->entry_count || registry->entries[id].role[0] == '\0') {
+        return NULL;
+    }
+    return &registry->entries[id];
+}
+
+int registry_pair(const Registry *registry, int id) {
+    const RegistryEntry *entry = registry_entry(registry, id);
+    return entry ? entry->pair : -1;
+}
+
+// Lowest id whose role contains text, -1 if none
+int registry_find_role(const Registry *registry, const char *text) {
+    for (int i = 0; registry && i < registry->entry_count; i++) {
+        if (registry->entries[i].role[0] && strstr(registry->entries[i].role, text)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The id a user typed, or -1 if text is not a plain number (a path)
+int registry_parse_number(const char *text) {
+    if (!text || !*text) {
+        return -1;
+    }
+    long id = 0;
+    for (const char *p = text; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return -1;
+        }
+        id = id * 10 + (*p - '0');
+        if (id > 0x7fffffff / 10) {
+            return -1;
+        }
+    }
+    return (int)id;
+}
+
+// name inside the registry's directory
+static const char *registry_join(const Registry *registry, const char *name, char *buffer, size_t size) {
+    int length;
+    if (registry && strcmp(registry->directory, ".") != 0) {
+        length = snprintf(buffer, size, "%s/%s", registry->directory, name);
+    } else {
+        length = snprintf(buffer, size, "%s", name);
+    }
+    // a cut-off path could name some other file, so hand back one that opens nothing
+    if (length < 0 || (size_t)length >= size) {
+        buffer[0] = '\0';
+    }
+    return buffer;
+}
+
+// Whether id lives under ab/cd/. 0.txt itself and the files it lists
+// always stay flat, so the registry, the character map and the tools'
+// own sources are where people expect them.
+static int registry_is_sharded(const Registry *registry, int id) {
+    return registry && registry->sharded && id != 0 && !registry_entry(registry, id);
+}
+
+// Where the loose copy of numbered file id lives. The only place the N.txt
+// naming is spelled out, so every tool agrees on it.
+const char *registry_path(const Registry *registry, int id, char *buffer, size_t size) {
+    char name[64];
+    if (registry_is_sharded(registry, id)) {
+        // Multiplicative hash, so consecutive ids spread over all shards
+        unsigned int shard = ((unsigned int)id * 2654435761u) >> 16;
+        snprintf(name, sizeof(name), "%02x/%02x/%d" REGISTRY_EXTENSION, shard >> 8, shard & 0xff, id);
+    } else {
+        snprintf(name, sizeof(name), "%d" REGISTRY_EXTENSION, id);
+    }
+    return registry_join(registry, name, buffer, size);
+}
+
+static void registry_make_directory(const char *path) {
+#ifdef _WIN32
+    _mkdir(path);
+#else
+    mkdir(path, 0777);
+#endif
+}
+
+// registry_path for a file about to be written: also creates its shard
+// directories
+const char *registry_create_path(const Registry *registry, int id, char *buffer, size_t size) {
+    registry_path(registry, id, buffer, size);
+    if (registry_is_sharded(registry, id)) {
+        for (char *slash = strchr(buffer + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+            *slash = '\0';
+            registry_make_directory(buffer);
+            *slash = '/';
+        }
+    }
+    return buffer;
+}
+
+static const char *registry_pack_path(const Registry *registry, int number, char *buffer, size_t size) {
+    char name[64];
+    snprintf(name, sizeof(name), REGISTRY_PACK_DIRECTORY "/%d.pack", number);
+    return registry_join(registry, name, buffer, size);
+}
+
+static unsigned int registry_read_u32(const unsigned char *bytes) {
+    return bytes[0] | bytes[1] << 8 | bytes[2] << 16 | (unsigned int)bytes[3] << 24;
+}
+
+static void registry_write_u32(unsigned char *bytes, unsigned int value) {
+    bytes[0] = value & 0xff;
+    bytes[1] = (value >> 8) & 0xff;
+    bytes[2] = (value >> 16) & 0xff;
+    bytes[3] = value >> 24;
+}
+
+// Table of contents of the pack holding id, read once. NULL if id has no
+// pack or memory ran out; a missing pack has exists == 0.
+static RegistryPack *registry_load_pack(Registry *registry, int id) {
+    if (!registry || id < 0 || id >= REGISTRY_MAX_ID) {
+        return NULL;
+    }
+    int number = id / REGISTRY_PACK_SPAN;
+    if (number >= registry->pack_count) {
+        RegistryPack **grown = realloc(registry->packs, (number + 1) * sizeof(RegistryPack *));
+        if (!grown) {
+            return NULL;
+        }
+        memset(grown + registry->pack_count, 0, (number + 1 - registry->pack_count) * sizeof(RegistryPack *));
+        registry->packs = grown;
+        registry->pack_count = number + 1;
+    }
+    if (registry->packs[number]) {
+        return registry->packs[number];
+    }
+
+    RegistryPack *pack = calloc(1, sizeof(RegistryPack));
+    if (!pack) {
+        return NULL;
+    }
+    registry->packs[number] = pack;
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    struct stat buffer;
+    registry_pack_path(registry, number, path, sizeof(path));
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return pack;
+    }
+    unsigned char *header = malloc(REGISTRY_PACK_HEADER);
+    if (header && fread(header, 1, REGISTRY_PACK_HEADER, file) == REGISTRY_PACK_HEADER &&
+            memcmp(header, REGISTRY_PACK_MAGIC, 8) == 0) {
+        for (int i = 0; i < REGISTRY_PACK_SPAN; i++) {
+            pack->offset[i] = registry_read_u32(header + 8 + i * 8);
+            pack->length[i] = registry_read_u32(header + 12 + i * 8);
+        }
+        pack->exists = 1;
+        pack->mtime = fstat(fileno(file), &buffer) == 0 ? buffer.st_mtime : 0;
+    } else {
+        printf("Warning: %s is not a pack file, ignoring it\n", path);
+    }
+    free(header);
+    fclose(file);
+    return pack;
+}
+
+// Copy length bytes, or everything up to EOF if length is -1. Returns how
+// many were copied, -1 on a short read or a write error.
+static long registry_copy(FILE *from, FILE *to, long length) {
+    char buffer[8192];
+    long copied = 0;
+    while (length < 0 || copied < length) {
+        size_t want = sizeof(buffer);
+        if (length >= 0 && (long)want > length - copied) {
+            want = (size_t)(length - copied);
+        }
+        size_t got = fread(buffer, 1, want, from);
+        if (got == 0) {
+            break;
+        }
+        if (fwrite(buffer, 1, got, to) != got) {
+            return -1;
+        }
+        copied += (long)got;
+    }
+    return length >= 0 && copied != length ? -1 : copied;
+}
+
+// Everything left to read in file, in a buffer the caller frees with room
+// for a terminating NUL after it. NULL if memory ran out.
+static char *registry_read_all(FILE *file, size_t *length) {
+    size_t capacity = 65536;
+    char *data = malloc(capacity);
+    size_t got;
+    *length = 0;
+    while (data && (got = fread(data + *length, 1, capacity - *length, file)) > 0) {
+        *length += got;
+        if (*length == capacity) {
+            char *grown = realloc(data, capacity * 2);
+            if (!grown) {
+                free(data);
+                return NULL;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+    }
+    return data;
+}
+
+static char *registry_expand(Registry *registry, char *data, size_t *length);
+
+// The stored form of id in a buffer the caller frees, with room for a
+// terminating NUL: the loose file if there is one, otherwise its packed
+// copy. NULL if it is in neither.
+static char *registry_load_stored(Registry *registry, int id, size_t *length) {
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    FILE *file = fopen(registry_path(registry, id, path, sizeof(path)), "rb");
+    if (file) {
+        char *data = registry_read_all(file, length);
+        fclose(file);
+        return data;
+    }
+    RegistryPack *pack = registry_load_pack(registry, id);
+    int slot = id % REGISTRY_PACK_SPAN;
+    if (!pack || !pack->offset[slot]) {
+        return NULL;
+    }
+
+    FILE *packed = fopen(registry_pack_path(registry, id / REGISTRY_PACK_SPAN, path, sizeof(path)), "rb");
+    *length = pack->length[slot];
+    char *data = packed ? malloc(*length + 1) : NULL;
+    if (data && (fseek(packed, (long)pack->offset[slot], SEEK_SET) != 0 ||
+            fread(data, 1, *length, packed) != *length)) {
+        free(data);
+        data = NULL;
+    }
+    if (packed) {
+        fclose(packed);
+    }
+    return data;
+}
+
+// Read numbered file id wherever it lives: loose, packed or as a manifest
+// of stored chunks, into a NUL-terminated buffer the caller frees. Nothing
+// goes through a temporary file. CRLF comes back as \n, as text mode reads
+// it on Windows. length, if not NULL, gets the length without the NUL.
+// NULL if it is in none of them.
+char *registry_read(Registry *registry, int id, size_t *length) {
+    size_t size = 0;
+    char *data = registry_expand(registry, registry_load_stored(registry, id, &size), &size);
+    if (!data) {
+        return NULL;
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (data[i] != '\r' || i + 1 == size || data[i + 1] != '\n') {
+            data[kept++] = data[i];
+        }
+    }
+    data[kept] = '\0';
+    if (length) {
+        *length = kept;
+    }
+    return data;
+}
+
+// fgets for a buffer: copies the line at *cursor, newline included, into
+// line (at most size - 1 characters of it) and moves *cursor past what was
+// copied. NULL at the end of the buffer.
+char *registry_gets(char *line, int size, const char **cursor) {
+    const char *next = *cursor;
+    int used = 0;
+    if (!*next || size < 2) {
+        return NULL;
+    }
+    while (*next && used < size - 1) {
+        line[used++] = *next;
+        if (*next++ == '\n') {
+            break;
+        }
+    }
+    line[used] = '\0';
+    *cursor = next;
+    return line;
+}
+
+static int registry_reserve_files(Registry *registry, int id) {
+    if (id < registry->file_count) {
+        return 1;
+    }
+    int count = registry->file_count > 0 ? registry->file_count : 64;
+    while (count <= id) {
+        count *= 2;
+    }
+    RegistryFile *grown = realloc(registry->files, count * sizeof(RegistryFile));
+    if (!grown) {
+        return 0;
+    }
+    // After a full scan, anything the scan did not see does not exist
+    for (int i = registry->file_count; i < count; i++) {
+        grown[i].known = registry->scanned;
+        grown[i].exists = 0;
+        grown[i].size = 0;
+        grown[i].mtime = 0;
+    }
+    registry->files = grown;
+    registry->file_count = count;
+    return 1;
+}
+
+// Size and mtime of N.txt, read once and then served from the cache
+// until registry_invalidate or registry_scan. A packed file has the
+// pack's mtime. Ids from REGISTRY_MAX_ID up are looked up afresh on
+// every call, into a record the next such call overwrites. NULL for a
+// bad id.
+const RegistryFile *registry_stat(Registry *registry, int id) {
+    RegistryFile *file;
+    if (!registry || id < 0) {
+        return NULL;
+    } else if (id >= REGISTRY_MAX_ID) {
+        file = &registry->untracked;
+        file->known = 0;
+    } else if (registry_reserve_files(registry, id)) {
+        file = &registry->files[id];
+    } else {
+        return NULL;
+    }
+    if (!file->known) {
+        char path[REGISTRY_FULL_PATH_LENGTH];
+        struct stat buffer;
+        registry_path(registry, id, path, sizeof(path));
+        file->known = 1;
+        file->exists = stat(path, &buffer) == 0;
+        file->size = file->exists ? (long long)buffer.st_size : 0;
+        file->mtime = file->exists ? buffer.st_mtime : 0;
+        RegistryPack *pack = file->exists ? NULL : registry_load_pack(registry, id);
+        if (pack && pack->offset[id % REGISTRY_PACK_SPAN]) {
+            file->exists = 1;
+            file->size = pack->length[id % REGISTRY_PACK_SPAN];
+            file->mtime = pack->mtime;
+        }
+    }
+    return file;
+}
+
+// Numbered id of a file name, -1 if it is not N.txt
+static int registry_name_id(const char *name) {
+    char number[64];
+    size_t length = strlen(name);
+    size_t suffix = strlen(REGISTRY_EXTENSION);
+    if (length <= suffix || length - suffix >= sizeof(number) ||
+            strcmp(name + length - suffix, REGISTRY_EXTENSION) != 0) {
+        return -1;
+    }
+    memcpy(number, name, length - suffix);
+    number[length - suffix] = '\0';
+    return registry_parse_number(number);
+}
+
+static int registry_is_shard_name(const char *name) {
+    return strlen(name) == 2 && strchr("0123456789abcdef", name[0]) && strchr("0123456789abcdef", name[1]);
+}
+
+// Append the ids of the loose N.txt files under path to *ids, descending
+// into ab/cd/ shard directories when the layout is sharded. Returns 0 if
+// path could not be read or memory ran out.
+static int registry_list_loose(const Registry *registry, const char *path, int depth,
+        int **ids, int *count, int *capacity) {
+    DIR *dir = opendir(path);
+    if (!dir) {
+        return 0;
+    }
+    int ok = 1;
+    struct dirent *entry;
+    while (ok && (entry = readdir(dir)) != NULL) {
+        int id = registry_name_id(entry->d_name);
+        if (id >= 0 && depth == 0 && registry_is_sharded(registry, id)) {
+            continue;  // left over from before sharding; only ab/cd/ counts
+        }
+        if (id < 0 && registry->sharded && depth < 2 && registry_is_shard_name(entry->d_name)) {
+            char child[REGISTRY_FULL_PATH_LENGTH];
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            registry_list_loose(registry, child, depth + 1, ids, count, capacity);
+            continue;
+        }
+        if (id < 0) {
+            continue;
+        }
+        if (*count == *capacity) {
+            int *grown = realloc(*ids, (*capacity ? *capacity * 2 : 256) * sizeof(int));
+            if (!grown) {
+                ok = 0;
+                break;
+            }
+            *ids = grown;
+            *capacity = *capacity ? *capacity * 2 : 256;
+        }
+        (*ids)[(*count)++] = id;
+    }
+    closedir(dir);
+    return ok;
+}
+
+// Read the metadata of every numbered file with one pass over the
+// directory (and its shards) and one table read per pack, so later
+// lookups never probe for files that are not there. Returns how many
+// numbered files were found, -1 if the directory could not be read.
+int registry_scan(Registry *registry) {
+    int *ids = NULL;
+    int count = 0;
+    int capacity = 0;
+    int untracked = 0;
+    if (!registry_list_loose(registry, registry->directory, 0, &ids, &count, &capacity)) {
+        free(ids);
+        return -1;
+    }
+    registry->scanned = 1;
+    for (int i = 0; i < registry->file_count; i++) {
+        registry->files[i].known = 1;
+        registry->files[i].exists = 0;
+    }
+    for (int i = 0; i < count; i++) {
+        if (ids[i] >= REGISTRY_MAX_ID) {
+            untracked++;  // found, but registry_stat does not cache it
+        } else if (registry_reserve_files(registry, ids[i])) {
+            registry->files[ids[i]].known = 0;
+            registry_stat(registry, ids[i]);
+        }
+    }
+    free(ids);
+
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    DIR *dir = opendir(registry_join(registry, REGISTRY_PACK_DIRECTORY, path, sizeof(path)));
+    struct dirent *entry;
+    while (dir && (entry = readdir(dir)) != NULL) {
+        char *dot = strrchr(entry->d_name, '.');
+        if (!dot || strcmp(dot, ".pack") != 0) {
+            continue;
+        }
+        *dot = '\0';
+        int number = registry_parse_number(entry->d_name);
+        RegistryPack *pack = number >= 0 ? registry_load_pack(registry, number * REGISTRY_PACK_SPAN) : NULL;
+        for (int slot = 0; pack && slot < REGISTRY_PACK_SPAN; slot++) {
+            int id = number * REGISTRY_PACK_SPAN + slot;
+            if (pack->offset[slot] && registry_reserve_files(registry, id) && !registry->files[id].exists) {
+                registry->files[id].known = 0;
+                registry_stat(registry, id);
+            }
+        }
+    }
+    if (dir) {
+        closedir(dir);
+    }
+
+    int found = untracked;
+    for (int i = 0; i < registry->file_count; i++) {
+        found += registry->files[i].exists;
+    }
+    return found;
+}
+
+// Forget everything cached about files, after files were moved around
+static void registry_forget_files(Registry *registry) {
+    free(registry->files);
+    registry->files = NULL;
+    registry->file_count = 0;
+    registry->scanned = 0;
+}
+
+// Forget the cached metadata of a file the caller has just written
+void registry_invalidate(Registry *registry, int id) {
+    if (registry && id >= 0 && id < registry->file_count) {
+        registry->files[id].known = 0;
+    }
+}
+
+// Switch the directory to the sharded layout and move every flat N.txt
+// that 0.txt does not list into its ab/cd/ directory. Returns how many
+// files were moved, -1 if the directory could not be read.
+int registry_shard(Registry *registry) {
+    int *ids = NULL;
+    int count = 0;
+    int capacity = 0;
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    char target[REGISTRY_FULL_PATH_LENGTH];
+    int was_sharded = registry->sharded;
+    registry->sharded = 0;  // list only the flat files
+    if (!registry_list_loose(registry, registry->directory, 0, &ids, &count, &capacity)) {
+        registry->sharded = was_sharded;
+        free(ids);
+        return -1;
+    }
+    FILE *marker = fopen(registry_join(registry, REGISTRY_SHARD_MARKER, path, sizeof(path)), "w");
+    if (!marker) {
+        printf("Error: Could not create %s\n", path);
+        registry->sharded = was_sharded;
+        free(ids);
+        return -1;
+    }
+    fclose(marker);
+
+    int moved = 0;
+    for (int i = 0; i < count; i++) {
+        registry_path(registry, ids[i], path, sizeof(path));
+        registry->sharded = 1;
+        registry_create_path(registry, ids[i], target, sizeof(target));
+        registry->sharded = 0;
+        if (strcmp(path, target) != 0 && rename(path, target) == 0) {
+            moved++;
+        }
+    }
+    registry->sharded = 1;
+    free(ids);
+    registry_forget_files(registry);
+    return moved;
+}
+
+static int registry_compare_ids(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+// Rewrite pack number with the loose files ids[0..count), which all belong
+// to it, on top of what it already holds. Returns 1 on success.
+static int registry_write_pack(Registry *registry, int number, const int *ids, int count) {
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    char temporary[REGISTRY_FULL_PATH_LENGTH + 8];
+    RegistryPack *old = registry_load_pack(registry, number * REGISTRY_PACK_SPAN);
+    unsigned char *header = calloc(1, REGISTRY_PACK_HEADER);
+    registry_pack_path(registry, number, path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE *file = header && old ? fopen(temporary, "wb") : NULL;
+    FILE *source = old && old->exists ? fopen(path, "rb") : NULL;
+    int ok = file != NULL && fwrite(header, 1, REGISTRY_PACK_HEADER, file) == REGISTRY_PACK_HEADER;
+
+    // Slots in id order; a loose file replaces its packed copy
+    long offset = REGISTRY_PACK_HEADER;
+    int next = 0;
+    for (int slot = 0; ok && slot < REGISTRY_PACK_SPAN; slot++) {
+        int id = number * REGISTRY_PACK_SPAN + slot;
+        long length = -1;
+        if (next < count && ids[next] == id) {
+            char loose[REGISTRY_FULL_PATH_LENGTH];
+            FILE *input = fopen(registry_path(registry, id, loose, sizeof(loose)), "rb");
+            length = input ? registry_copy(input, file, -1) : -1;
+            ok = input != NULL && length >= 0;
+            if (input) {
+                fclose(input);
+            }
+            next++;
+        } else if (old->offset[slot]) {
+            ok = source && fseek(source, (long)old->offset[slot], SEEK_SET) == 0;
+            length = ok ? registry_copy(source, file, (long)old->length[slot]) : -1;
+            ok = ok && length >= 0;
+        }
+        if (ok && length >= 0) {
+            registry_write_u32(header + 8 + slot * 8, (unsigned int)offset);
+            registry_write_u32(header + 12 + slot * 8, (unsigned int)length);
+            offset += length;
+        }
+    }
+    memcpy(header, REGISTRY_PACK_MAGIC, 8);
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(header, 1, REGISTRY_PACK_HEADER, file) == REGISTRY_PACK_HEADER;
+    if (file) {
+        ok = fclose(file) == 0 && ok;
+    }
+    if (source) {
+        fclose(source);
+    }
+    free(header);
+
+    // rename() swaps the new pack in atomically on POSIX, so readers see
+    // either pack whole. Windows will not rename over an existing file.
+#ifdef _WIN32
+    if (ok) {
+        remove(path);
+    }
+#endif
+    if (!ok || rename(temporary, path) != 0) {
+        remove(temporary);
+        printf("Error: Could not write %s\n", path);
+        return 0;
+    }
+    return 1;
+}
+
+// Bundle every loose file of at most REGISTRY_PACK_SMALL bytes, below
+// REGISTRY_MAX_ID, that 0.txt does not list (nor 0.txt) into its pack,
+// merged with what the pack already holds, then remove the loose copies.
+// Returns how many files were packed, -1 if the directory could not be
+// read or a pack could not be written.
+int registry_pack(Registry *registry) {
+    int *ids = NULL;
+    int count = 0;
+    int capacity = 0;
+    if (!registry_list_loose(registry, registry->directory, 0, &ids, &count, &capacity)) {
+        free(ids);
+        return -1;
+    }
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    int small = 0;
+    for (int i = 0; i < count; i++) {
+        const RegistryFile *file = registry_stat(registry, ids[i]);
+        if (ids[i] != 0 && ids[i] < REGISTRY_MAX_ID && !registry_entry(registry, ids[i]) &&
+                file && file->size <= REGISTRY_PACK_SMALL) {
+            ids[small++] = ids[i];
+        }
+    }
+    qsort(ids, small, sizeof(int), registry_compare_ids);
+    registry_make_directory(registry_join(registry, REGISTRY_PACK_DIRECTORY, path, sizeof(path)));
+
+    int packed = 0;
+    for (int first = 0; first < small; ) {
+        int number = ids[first] / REGISTRY_PACK_SPAN;
+        int last = first;
+        while (last < small && ids[last] / REGISTRY_PACK_SPAN == number) {
+            last++;
+        }
+        if (!registry_write_pack(registry, number, ids + first, last - first)) {
+            packed = -1;
+            break;
+        }
+        for (int i = first; i < last; i++) {
+            remove(registry_path(registry, ids[i], path, sizeof(path)));
+        }
+        packed += last - first;
+        free(registry->packs[number]);
+        registry->packs[number] = NULL;
+        first = last;
+    }
+    free(ids);
+    registry_forget_files(registry);
+    return packed;
+}
+
+static const uint32_t registry_sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define REGISTRY_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void registry_sha256_block(uint32_t *state, const unsigned char *block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)block[i * 4] << 24 | (uint32_t)block[i * 4 + 1] << 16 | (uint32_t)block[i * 4 + 2] << 8 | block[i * 4 + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = REGISTRY_ROTR(w[i - 15], 7) ^ REGISTRY_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = REGISTRY_ROTR(w[i - 2], 17) ^ REGISTRY_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (REGISTRY_ROTR(e, 6) ^ REGISTRY_ROTR(e, 11) ^ REGISTRY_ROTR(e, 25)) + ((e & f) ^ (~e & g)) +
+            registry_sha256_k[i] + w[i];
+        uint32_t t2 = (REGISTRY_ROTR(a, 2) ^ REGISTRY_ROTR(a, 13) ^ REGISTRY_ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+// SHA-256 of data as 64 hex digits, the name a chunk is stored under
+static void registry_sha256(const unsigned char *data, size_t length, char hex[65]) {
+    uint32_t state[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    size_t done = 0;
+    for (; done + 64 <= length; done += 64) {
+        registry_sha256_block(state, data + done);
+    }
+    unsigned char tail[128] = { 0 };
+    size_t rest = length - done;
+    size_t tail_length = rest + 9 <= 64 ? 64 : 128;
+    memcpy(tail, data + done, rest);
+    tail[rest] = 0x80;
+    uint64_t bits = (uint64_t)length * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_length - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    registry_sha256_block(state, tail);
+    if (tail_length == 128) {
+        registry_sha256_block(state, tail + 64);
+    }
+    for (int i = 0; i < 8; i++) {
+        snprintf(hex + i * 8, 9, "%08x", (unsigned int)state[i]);
+    }
+}
+
+// Length of the chunk at the start of data. The cut falls after the first
+// byte past REGISTRY_CHUNK_MIN where the gear hash (which only remembers
+// the last 64 bytes) has its top bits clear, so it depends on the nearby
+// content and not on the offset: an insertion moves the cuts after it
+// along with the bytes instead of changing every chunk.
+static size_t registry_next_chunk(const unsigned char *data, size_t length) {
+    static uint64_t gear[256];
+    static int gear_ready = 0;
+    if (!gear_ready) {
+        // splitmix64, so registry.py can build the same table
+        uint64_t seed = 0;
+        for (int i = 0; i < 256; i++) {
+            uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            gear[i] = z ^ (z >> 31);
+        }
+        gear_ready = 1;
+    }
+    size_t limit = length < REGISTRY_CHUNK_MAX ? length : REGISTRY_CHUNK_MAX;
+    uint64_t hash = 0;
+    for (size_t i = REGISTRY_CHUNK_MIN; i < limit; i++) {
+        hash = (hash << 1) + gear[data[i]];
+        if (!(hash & REGISTRY_CHUNK_MASK)) {
+            return i + 1;
+        }
+    }
+    return limit;
+}
+
+static const char *registry_chunk_path(const Registry *registry, const char *hash, char *buffer, size_t size) {
+    char name[128];
+    snprintf(name, sizeof(name), REGISTRY_CHUNK_DIRECTORY "/%.2s/%s", hash, hash);
+    return registry_join(registry, name, buffer, size);
+}
+
+// Store one chunk unless the store already has it. Returns 1 on success.
+static int registry_write_chunk(Registry *registry, const char *hash, const char *data, size_t size) {
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    char temporary[REGISTRY_FULL_PATH_LENGTH + 8];
+    struct stat buffer;
+    registry->stored_chunks++;
+    if (stat(registry_chunk_path(registry, hash, path, sizeof(path)), &buffer) == 0 && (size_t)buffer.st_size == size) {
+        return 1;
+    }
+    registry_make_directory(registry_join(registry, REGISTRY_CHUNK_DIRECTORY, temporary, sizeof(temporary)));
+    *strrchr(path, '/') = '\0';
+    registry_make_directory(path);
+    registry_chunk_path(registry, hash, path, sizeof(path));
+
+    // Written under a temporary name, so a crash never leaves a short
+    // chunk under the real one
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE *file = fopen(temporary, "wb");
+    int ok = file != NULL && fwrite(data, 1, size, file) == size;
+    if (file) {
+        ok = fclose(file) == 0 && ok;
+    }
+#ifdef _WIN32
+    if (ok) {
+        remove(path);  // rename() will not replace an existing file on Windows
+    }
+#endif
+    if (!ok || rename(temporary, path) != 0) {
+        remove(temporary);
+        printf("Error: Could not write chunk %s\n", path);
+        return 0;
+    }
+    registry->new_chunks++;
+    registry->new_bytes += (long long)size;
+    return 1;
+}
+
+// Store data as numbered file id: write the chunks the store does not
+// have yet, then replace N.txt with a manifest of all of them. Counts go
+// to stored_chunks, new_chunks and new_bytes. Returns 1 on success.
+int registry_store(Registry *registry, int id, const char *data, size_t length) {
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    char temporary[REGISTRY_FULL_PATH_LENGTH + 8];
+    registry->stored_chunks = 0;
+    registry->new_chunks = 0;
+    registry->new_bytes = 0;
+    registry_create_path(registry, id, path, sizeof(path));
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+    FILE *manifest = fopen(temporary, "w");
+    if (!manifest) {
+        printf("Error: Could not write %s\n", temporary);
+        return 0;
+    }
+
+    int ok = fputs(REGISTRY_MANIFEST_MAGIC "\n", manifest) >= 0;
+    for (size_t offset = 0; ok && offset < length; ) {
+        size_t size = registry_next_chunk((const unsigned char *)data + offset, length - offset);
+        char hash[65];
+        registry_sha256((const unsigned char *)data + offset, size, hash);
+        ok = registry_write_chunk(registry, hash, data + offset, size) &&
+            fprintf(manifest, "%s %lu\n", hash, (unsigned long)size) > 0;
+        offset += size;
+    }
+    ok = fclose(manifest) == 0 && ok;
+
+    // The old file stays readable until rename() swaps the manifest in;
+    // Windows will not rename over an existing file
+#ifdef _WIN32
+    if (ok) {
+        remove(path);
+    }
+#endif
+    if (!ok || rename(temporary, path) != 0) {
+        remove(temporary);
+        printf("Error: Could not write %s\n", path);
+        return 0;
+    }
+    registry_invalidate(registry, id);
+    return 1;
+}
+
+// If data is a manifest, free it and hand back the content it lists,
+// reassembled in a new buffer with room for a terminating NUL; otherwise
+// hand back data. length is updated to match. NULL if a chunk is missing
+// or damaged, or the manifest names one by anything but its 64-digit hash
+// (which keeps it inside chunks/).
+static char *registry_expand(Registry *registry, char *data, size_t *length) {
+    char line[160] = "";
+    const char *cursor = data;
+    if (!data) {
+        return NULL;
+    }
+    data[*length] = '\0';
+    if (registry_gets(line, sizeof(line), &cursor)) {
+        line[strcspn(line, "\r\n")] = '\0';
+    }
+    if (strcmp(line, REGISTRY_MANIFEST_MAGIC) != 0) {
+        return data;
+    }
+
+    size_t capacity = 65536;
+    char *content = malloc(capacity);
+    *length = 0;
+    while (content && registry_gets(line, sizeof(line), &cursor)) {
+        char hash[65];
+        char path[REGISTRY_FULL_PATH_LENGTH];
+        char size_text[16];
+        if (sscanf(line, "%64s %15s", hash, size_text) != 2) {
+            continue;
+        }
+        long size = registry_parse_number(size_text);
+        if (strlen(hash) != 64 || strspn(hash, "0123456789abcdef") != 64 || size < 0 || size > REGISTRY_CHUNK_MAX) {
+            printf("Error: Bad manifest line %s", line);
+            free(content);
+            content = NULL;
+            break;
+        }
+        if (*length + (size_t)size >= capacity) {
+            while (*length + (size_t)size >= capacity) {
+                capacity *= 2;
+            }
+            char *grown = realloc(content, capacity);
+            if (!grown) {
+                free(content);
+                content = NULL;
+                break;
+            }
+            content = grown;
+        }
+        // the chunk must hold exactly size bytes, no fewer and no more
+        FILE *chunk = fopen(registry_chunk_path(registry, hash, path, sizeof(path)), "rb");
+        int intact = chunk && fread(content + *length, 1, (size_t)size, chunk) == (size_t)size &&
+            fgetc(chunk) == EOF;
+        if (chunk) {
+            fclose(chunk);
+        }
+        if (!intact) {
+            printf("Error: Chunk %s is missing or damaged\n", path);
+            free(content);
+            content = NULL;
+        } else {
+            *length += (size_t)size;
+        }
+    }
+    free(data);
+    return content;
+}
+
+// Turn the store on and move every loose file that holds encoded output
+// (only digits and whitespace) into it. Returns how many files became
+// manifests, -1 if the directory could not be read.
+int registry_deduplicate(Registry *registry) {
+    int *ids = NULL;
+    int count = 0;
+    int capacity = 0;
+    char path[REGISTRY_FULL_PATH_LENGTH];
+    if (!registry_list_loose(registry, registry->directory, 0, &ids, &count, &capacity)) {
+        free(ids);
+        return -1;
+    }
+    FILE *marker = fopen(registry_join(registry, REGISTRY_DEDUP_MARKER, path, sizeof(path)), "w");
+    if (!marker) {
+        printf("Error: Could not create %s\n", path);
+        free(ids);
+        return -1;
+    }
+    fclose(marker);
+    registry->deduplicated = 1;
+
+    int converted = 0;
+    for (int i = 0; i < count; i++) {
+        // Read and closed first, as registry_store replaces the file
+        FILE *file = fopen(registry_path(registry, ids[i], path, sizeof(path)), "rb");
+        size_t length = 0;
+        char *data = file ? registry_read_all(file, &length) : NULL;
+        if (file) {
+            fclose(file);
+        }
+        // Only encoded output is chunked; sources and maps stay as they are
+        int encoded = length > 0;
+        for (size_t j = 0; data && encoded && j < length; j++) {
+            encoded = strchr("0123456789 \t\r\n", data[j]) != NULL && data[j] != '\0';
+        }
+        if (data && encoded) {
+            converted += registry_store(registry, ids[i], data, length);
+        }
+        free(data);
+    }
+    free(ids);
+    registry_forget_files(registry);
+    return converted;
+}
+
+#endif
\ No newline at end of file
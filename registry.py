@@ -0,0 +1,311 @@
+# Registry of the numbered .txt file system described in 0.txt, the Python
+# side of registry.h. See that header for the 0.txt format, the sharded
+# layout, the pack format and the chunk store. Packs and shards are made
+# by 0.c --pack and --shard; this side only finds files in them.
+import hashlib
+import io
+import os
+import struct
+
+REGISTRY_FILE = "0.txt"
+REGISTRY_EXTENSION = ".txt"
+REGISTRY_SHARD_MARKER = ".sharded"
+REGISTRY_PACK_DIRECTORY = "packs"
+REGISTRY_PACK_MAGIC = b"NTXPACK1"
+REGISTRY_PACK_SPAN = 4096
+REGISTRY_PACK_HEADER = 8 + REGISTRY_PACK_SPAN * 8
+REGISTRY_DEDUP_MARKER = ".deduplicated"
+REGISTRY_CHUNK_DIRECTORY = "chunks"
+REGISTRY_MANIFEST_MAGIC = "NTXCHUNKS1"
+REGISTRY_CHUNK_MIN = 2048
+REGISTRY_CHUNK_MAX = 65536
+REGISTRY_CHUNK_MASK = 0xfff8000000000000
+MASK64 = 0xffffffffffffffff
+
+
+def _gear_table():
+    # splitmix64, the same table registry.h builds
+    table = []
+    seed = 0
+    for _ in range(256):
+        seed = (seed + 0x9e3779b97f4a7c15) & MASK64
+        z = seed
+        z = ((z ^ (z >> 30)) * 0xbf58476d1ce4e5b9) & MASK64
+        z = ((z ^ (z >> 27)) * 0x94d049bb133111eb) & MASK64
+        table.append(z ^ (z >> 31))
+    return table
+
+
+GEAR = _gear_table()
+
+
+class RegistryEntry:
+    def __init__(self, id, role):
+        self.id = id
+        self.role = role
+        # 1 encoded, 0 decoded, -1 neither
+        self.encoded = 1 if "encoded" in role else (0 if "decoded" in role else -1)
+        # id of the other half of an encoded/decoded pair, -1 if none
+        self.pair = -1
+
+
+class Registry:
+    def __init__(self, directory="."):
+        self.directory = directory or "."
+        self.entries = {}
+        self.files = {}
+        self.scanned = False
+        self.sharded = os.path.exists(os.path.join(self.directory, REGISTRY_SHARD_MARKER))
+        # Table of contents per pack number: None if there is no such pack,
+        # else (mtime, [(offset, length)] * REGISTRY_PACK_SPAN)
+        self.packs = {}
+        self.deduplicated = os.path.exists(os.path.join(self.directory, REGISTRY_DEDUP_MARKER))
+        # Chunks in the last store(), and how many of them were new
+        self.stored_chunks = 0
+        self.new_chunks = 0
+
+        # A missing 0.txt gives an empty registry, so paths still resolve
+        try:
+            with open(os.path.join(self.directory, REGISTRY_FILE), 'r') as file:
+                lines = file.read().splitlines()
+        except OSError:
+            lines = []
+
+        in_txt_system = False
+        for line in lines:
+            if '{' in line:
+                in_txt_system = f"({REGISTRY_EXTENSION} " in line
+                continue
+            if line.startswith('}'):
+                in_txt_system = False
+                continue
+            number, tab, role = line.partition('\t')
+            id = self.parse_number(number)
+            if in_txt_system and tab and id >= 0:
+                self.entries[id] = RegistryEntry(id, role)
+
+        # Pair each encoded file with the decoded file of the same role
+        for id in sorted(self.entries):
+            entry = self.entries[id]
+            if entry.encoded != 1:
+                continue
+            for other_id in sorted(self.entries):
+                other = self.entries[other_id]
+                if other.encoded == 0 and other.pair < 0 and self._pair_key(other.role) == self._pair_key(entry.role):
+                    entry.pair = other_id
+                    other.pair = id
+                    break
+
+    @staticmethod
+    def _pair_key(role):
+        # Role text with its "encoded"/"decoded" word removed
+        for word in ("encoded", "decoded"):
+            if word in role:
+                return role.replace(word, "", 1)
+        return role
+
+    def entry(self, id):
+        return self.entries.get(id)
+
+    def pair(self, id):
+        entry = self.entries.get(id)
+        return entry.pair if entry else -1
+
+    def find_role(self, text):
+        # Lowest id whose role contains text, -1 if none
+        for id in sorted(self.entries):
+            if text in self.entries[id].role:
+                return id
+        return -1
+
+    @staticmethod
+    def parse_number(text):
+        # The id a user typed, or -1 if text is not a plain number (a path)
+        text = text.strip() if text else ""
+        return int(text) if text.isdigit() and text.isascii() else -1
+
+    def _join(self, name):
+        return name if self.directory == "." else os.path.join(self.directory, name)
+
+    def _is_sharded(self, id):
+        # 0.txt and the files it lists always stay flat
+        return self.sharded and id != 0 and id not in self.entries
+
+    def path(self, id):
+        # Where the loose copy of id lives; the only place the N.txt naming
+        # is spelled out
+        name = f"{id}{REGISTRY_EXTENSION}"
+        if self._is_sharded(id):
+            shard = ((id * 2654435761) & 0xffffffff) >> 16
+            name = f"{shard >> 8:02x}/{shard & 0xff:02x}/{name}"
+        return self._join(name)
+
+    def create_path(self, id):
+        # path() for a file about to be written: also creates its shard
+        # directories
+        path = self.path(id)
+        if self._is_sharded(id):
+            os.makedirs(os.path.dirname(path), exist_ok=True)
+        return path
+
+    def _pack(self, id):
+        # Table of contents of the pack holding id, read once
+        number = id // REGISTRY_PACK_SPAN
+        if number not in self.packs:
+            self.packs[number] = None
+            path = self._join(f"{REGISTRY_PACK_DIRECTORY}/{number}.pack")
+            try:
+                with open(path, 'rb') as file:
+                    header = file.read(REGISTRY_PACK_HEADER)
+                    mtime = os.fstat(file.fileno()).st_mtime
+            except OSError:
+                header = b""
+            if len(header) == REGISTRY_PACK_HEADER and header[:8] == REGISTRY_PACK_MAGIC:
+                slots = list(struct.iter_unpack('<II', header[8:]))
+                self.packs[number] = (mtime, slots)
+        return self.packs[number]
+
+    def open(self, id):
+        # Open id for reading wherever it lives: loose, packed or as a
+        # manifest of stored chunks. Raises OSError if it is in none of them.
+        try:
+            with open(self.path(id), 'rb') as file:
+                data = file.read()
+        except OSError:
+            pack = self._pack(id)
+            offset, length = pack[1][id % REGISTRY_PACK_SPAN] if pack else (0, 0)
+            if not offset:
+                raise
+            with open(self._join(f"{REGISTRY_PACK_DIRECTORY}/{id // REGISTRY_PACK_SPAN}.pack"), 'rb') as file:
+                file.seek(offset)
+                data = file.read(length)
+        if data.startswith(REGISTRY_MANIFEST_MAGIC.encode()):
+            data = self._expand(data)
+        return io.TextIOWrapper(io.BytesIO(data))
+
+    def _chunk_path(self, hash):
+        return self._join(f"{REGISTRY_CHUNK_DIRECTORY}/{hash[:2]}/{hash}")
+
+    def _expand(self, manifest):
+        # The content a manifest lists, from its chunks. A chunk is only
+        # ever named by its 64-digit hash, which keeps it inside chunks/.
+        parts = []
+        for line in manifest.decode().splitlines()[1:]:
+            fields = line.split()
+            if len(fields) != 2:
+                continue
+            hash, size = fields[0], self.parse_number(fields[1])
+            if len(hash) != 64 or any(c not in "0123456789abcdef" for c in hash) or size < 0 or size > REGISTRY_CHUNK_MAX:
+                raise OSError(f"Bad manifest line {line}")
+            with open(self._chunk_path(hash), 'rb') as file:
+                chunk = file.read()
+            if len(chunk) != size:
+                raise OSError(f"Chunk {fields[0]} is damaged")
+            parts.append(chunk)
+        return b"".join(parts)
+
+    @staticmethod
+    def _next_chunk(data, start):
+        # End of the chunk starting at start; see registry_next_chunk
+        limit = min(len(data), start + REGISTRY_CHUNK_MAX)
+        hash = 0
+        for i in range(start + REGISTRY_CHUNK_MIN, limit):
+            hash = ((hash << 1) + GEAR[data[i]]) & MASK64
+            if not hash & REGISTRY_CHUNK_MASK:
+                return i + 1
+        return limit
+
+    def store(self, id, text):
+        # Store text as numbered file id: write the chunks the store does
+        # not have yet, then replace N.txt with a manifest of all of them
+        data = text.encode()
+        path = self.create_path(id)
+        lines = [REGISTRY_MANIFEST_MAGIC]
+        self.stored_chunks = 0
+        self.new_chunks = 0
+        start = 0
+        while start < len(data):
+            end = self._next_chunk(data, start)
+            chunk = data[start:end]
+            hash = hashlib.sha256(chunk).hexdigest()
+            chunk_path = self._chunk_path(hash)
+            self.stored_chunks += 1
+            if not (os.path.exists(chunk_path) and os.path.getsize(chunk_path) == len(chunk)):
+                os.makedirs(os.path.dirname(chunk_path), exist_ok=True)
+                with open(chunk_path + ".tmp", 'wb') as file:
+                    file.write(chunk)
+                os.replace(chunk_path + ".tmp", chunk_path)
+                self.new_chunks += 1
+            lines.append(f"{hash} {len(chunk)}")
+            start = end
+        with open(path + ".tmp", 'w') as file:
+            file.write("\n".join(lines) + "\n")
+        os.replace(path + ".tmp", path)
+        self.invalidate(id)
+
+    def stat(self, id):
+        # (exists, size, mtime) of N.txt, cached until invalidate or scan
+        if id not in self.files:
+            if self.scanned:
+                return (False, 0, 0)
+            self.files[id] = self._read_stat(id)
+        return self.files[id]
+
+    def _read_stat(self, id):
+        try:
+            info = os.stat(self.path(id))
+            return (True, info.st_size, info.st_mtime)
+        except OSError:
+            pack = self._pack(id)
+            offset, length = pack[1][id % REGISTRY_PACK_SPAN] if pack else (0, 0)
+            return (True, length, pack[0]) if offset else (False, 0, 0)
+
+    def _list_loose(self, path, depth):
+        # (id, DirEntry) of the loose N.txt files under path, descending
+        # into ab/cd/ shard directories when the layout is sharded
+        for entry in os.scandir(path):
+            name = entry.name
+            if self.sharded and depth < 2 and len(name) == 2 and all(c in "0123456789abcdef" for c in name):
+                yield from self._list_loose(entry.path, depth + 1)
+                continue
+            if not name.endswith(REGISTRY_EXTENSION):
+                continue
+            id = self.parse_number(name[:-len(REGISTRY_EXTENSION)])
+            if id >= 0 and not (depth == 0 and self._is_sharded(id)):
+                yield id, entry
+
+    def scan(self):
+        # Read the metadata of every numbered file with one pass over the
+        # directory (and its shards) and one table read per pack. Returns
+        # how many were found, -1 if the directory could not be read.
+        try:
+            entries = list(self._list_loose(self.directory, 0))
+        except OSError:
+            return -1
+        self.files = {}
+        self.scanned = True
+        for id, entry in entries:
+            try:
+                info = entry.stat()
+                self.files[id] = (True, info.st_size, info.st_mtime)
+            except OSError:
+                pass
+        try:
+            packs = os.listdir(self._join(REGISTRY_PACK_DIRECTORY))
+        except OSError:
+            packs = []
+        for name in packs:
+            number = self.parse_number(name[:-len(".pack")]) if name.endswith(".pack") else -1
+            pack = self._pack(number * REGISTRY_PACK_SPAN) if number >= 0 else None
+            for slot, (offset, length) in enumerate(pack[1] if pack else []):
+                if offset and number * REGISTRY_PACK_SPAN + slot not in self.files:
+                    self.files[number * REGISTRY_PACK_SPAN + slot] = (True, length, pack[0])
+        return len(self.files)
+
+    def invalidate(self, id):
+        # Forget the cached metadata of a file the caller has just written.
+        # After a scan a missing entry means no file, so that one entry is
+        # read again now; the rest of the scan stays valid.
+        self.files.pop(id, None)
+        if self.scanned:
+            self.files[id] = self._read_stat(id)
\ No newline at end of file